@@ -0,0 +1,102 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BaseCollectible.h"
+#include "FirstRPG.h"
+#include "FirstRPGCharacter.h"
+#include "GameplayTelemetry.h"
+#include "StreamingStateSubsystem.h"
+#include "Components/SphereComponent.h"
+#include "Components/StaticMeshComponent.h"
+
+// Sets default values
+ABaseCollectible::ABaseCollectible()
+{
+	LLM_SCOPE_BYTAG(FirstRPG_Items);
+
+	//Pickups only react to overlaps
+	PrimaryActorTick.bCanEverTick = false;
+
+	collisionSphere = CreateDefaultSubobject<USphereComponent>(TEXT("CollisionSphere"));
+	collisionSphere->InitSphereRadius(50.0f);
+	collisionSphere->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+	collisionSphere->SetCollisionObjectType(ECC_Pickup);
+	collisionSphere->SetCollisionResponseToAllChannels(ECR_Ignore);
+	collisionSphere->SetCollisionResponseToChannel(ECC_Pawn, ECR_Overlap);
+	collisionSphere->SetGenerateOverlapEvents(true);
+	RootComponent = collisionSphere;
+
+	mesh = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("Mesh"));
+	mesh->SetupAttachment(collisionSphere);
+	mesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	mesh->SetGenerateOverlapEvents(false);
+
+	effect = ECollectibleEffect::E_Health;
+	amount = 0.2f;
+
+	//Collect for a player already standing where the pickup streams in, not only one who walks in later
+	bGenerateOverlapEventsDuringLevelStreaming = true;
+}
+
+void ABaseCollectible::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	collisionSphere->OnComponentBeginOverlap.AddDynamic(this, &ABaseCollectible::OnSphereBeginOverlap);
+}
+
+// Called when the game starts or when spawned
+void ABaseCollectible::BeginPlay()
+{
+	Super::BeginPlay();
+
+	//Already picked up before this cell last streamed out
+	UStreamingStateSubsystem* streamingState = GetWorld()->GetSubsystem<UStreamingStateSubsystem>();
+	if (streamingState != nullptr && streamingState->WasCollected(this))
+	{
+		Destroy();
+	}
+}
+
+void ABaseCollectible::OnSphereBeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
+{
+	AFirstRPGCharacter* player = Cast<AFirstRPGCharacter>(OtherActor);
+	if (player == nullptr || IsActorBeingDestroyed())
+	{
+		return;
+	}
+
+	//Initial overlaps arrive before BeginPlay has had the chance to remove a pickup collected on an earlier visit
+	UStreamingStateSubsystem* streamingState = GetWorld()->GetSubsystem<UStreamingStateSubsystem>();
+	if (streamingState != nullptr && streamingState->WasCollected(this))
+	{
+		return;
+	}
+
+	ApplyEffect(player);
+	OnCollected(player);
+	FGameplayTelemetry::Record(ETelemetryEvent::Pickup, player, GetClass()->GetFName(), amount);
+
+	if (streamingState != nullptr)
+	{
+		streamingState->MarkCollected(this);
+	}
+
+	Destroy();
+}
+
+void ABaseCollectible::ApplyEffect(AFirstRPGCharacter* _player)
+{
+	switch (effect)
+	{
+	case ECollectibleEffect::E_Health:
+		_player->Heal(amount);
+		break;
+	case ECollectibleEffect::E_Shield:
+		_player->HealArmor(amount);
+		break;
+	case ECollectibleEffect::E_Experience:
+		_player->GainExperience(amount);
+		break;
+	}
+}
@@ -0,0 +1,64 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "BaseCollectible.generated.h"
+
+class USphereComponent;
+class UStaticMeshComponent;
+class AFirstRPGCharacter;
+
+UENUM(BlueprintType)
+enum class ECollectibleEffect : uint8
+{
+	E_Health		UMETA(DisplayName = "HEALTH"),
+	E_Shield		UMETA(DisplayName = "SHIELD"),
+	E_Experience	UMETA(DisplayName = "EXPERIENCE")
+};
+
+/**
+ * Pickup that applies its effect to the player natively on overlap. It never ticks, and its
+ * sphere sits on the Pickup channel, so only the player's capsule ever generates an overlap with it.
+ */
+UCLASS()
+class FIRSTRPG_API ABaseCollectible : public AActor
+{
+	GENERATED_BODY()
+	
+public:	
+	// Sets default values for this actor's properties
+	ABaseCollectible();
+
+protected:
+	// Called when the game starts or when spawned
+	virtual void BeginPlay() override;
+
+	//Binds the overlap event before initial overlaps are dispatched, which happens ahead of BeginPlay
+	virtual void PostInitializeComponents() override;
+
+	UFUNCTION()
+	void OnSphereBeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
+
+	//Applies the effect to the player who picked this up
+	virtual void ApplyEffect(AFirstRPGCharacter* _player);
+
+	//For pickup sounds and particles in the Blueprint; the effect has already been applied
+	UFUNCTION(BlueprintImplementableEvent, Category = "Collectible")
+	void OnCollected(AFirstRPGCharacter* _player);
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Collectible")
+	USphereComponent* collisionSphere;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Collectible")
+	UStaticMeshComponent* mesh;
+
+	//What the pickup does
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Collectible")
+	ECollectibleEffect effect;
+
+	//How much health, shield or experience it gives
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Collectible")
+	float amount;
+};
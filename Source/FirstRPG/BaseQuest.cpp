@@ -2,25 +2,36 @@
 
 
 #include "BaseQuest.h"
+#include "FirstRPG.h"
+#include "GameplayTelemetry.h"
 
 UBaseQuest::UBaseQuest()
 {
-	name = "Default Quest";
-	description = "Go do this";
+	LLM_SCOPE_BYTAG(FirstRPG_Quests);
+
+	questId = TEXT("DefaultQuest");
+	displayName = FText::FromStringTable(FirstRPGStringTables::Quests, TEXT("DefaultQuest"));
+	description = FText::FromStringTable(FirstRPGStringTables::Quests, TEXT("DefaultQuest_Description"));
 
 	reward.rewardType = EQuestReward::E_Default;
 	reward.experience = 100.0f;
 	reward.item = nullptr;
+	reward.lootTable = nullptr;
 }
 
-void UBaseQuest::SetQuestDetails(FString _name, FString _description)
+void UBaseQuest::SetQuestDetails(FName _questId, FText _displayName, FText _description)
 {
-	name = _name;
+	LLM_SCOPE_BYTAG(FirstRPG_Quests);
+
+	questId = _questId;
+	displayName = _displayName;
 	description = _description;
 }
 
-void UBaseQuest::SetUpObjective(int _objectiveNum, TSubclassOf<AMyActor> _enemy, TSubclassOf<ADefaultItem> _item, FString _description, int _numRequired)
+void UBaseQuest::SetUpObjective(int _objectiveNum, TSubclassOf<AMyActor> _enemy, TSubclassOf<ADefaultItem> _item, FText _description, int _numRequired)
 {
+	LLM_SCOPE_BYTAG(FirstRPG_Quests);
+
 	if (_objectiveNum < objectives.Num())
 	{
 		if (_enemy != nullptr)
@@ -36,10 +47,28 @@ void UBaseQuest::SetUpObjective(int _objectiveNum, TSubclassOf<AMyActor> _enemy,
 
 		objectives[_objectiveNum].description = _description;
 		objectives[_objectiveNum].numRequired = _numRequired;
+		objectives[_objectiveNum].numCompleted = 0;
 	}
 }
 
 void UBaseQuest::SetNumObjectives(int _numObjectives)
 {
+	LLM_SCOPE_BYTAG(FirstRPG_Quests);
+
 	objectives.SetNum(_numObjectives);
-}
\ No newline at end of file
+}
+
+bool UBaseQuest::AdvanceObjective(int _objectiveNum, int _amount)
+{
+	if (!objectives.IsValidIndex(_objectiveNum))
+	{
+		return false;
+	}
+
+	FObjective& objective = objectives[_objectiveNum];
+	objective.numCompleted = FMath::Min(objective.numCompleted + _amount, objective.numRequired);
+
+	FGameplayTelemetry::Record(ETelemetryEvent::QuestObjective, this, questId, (float)_objectiveNum, (float)objective.numCompleted);
+
+	return objective.numCompleted >= objective.numRequired;
+}
@@ -8,6 +8,8 @@
 #include "MyActor.h"
 #include "BaseQuest.generated.h"
 
+class ULootTable;
+
 /**
  * 
  */
@@ -17,7 +19,8 @@ enum class EQuestReward : uint8
 {
 	E_Default		UMETA(DisplayName = "DEFAULT"),
 	E_Experience	UMETA(DisplayName = "EXPERIENCE"),
-	E_Item			UMETA(DisplayName = "ITEM")
+	E_Item			UMETA(DisplayName = "ITEM"),
+	E_Loot			UMETA(DisplayName = "LOOT")
 };
 
 UENUM(BlueprintType)
@@ -43,6 +46,10 @@ public:
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	float experience;
+
+	//Rolled when rewardType is LOOT
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	ULootTable* lootTable;
 };
 
 USTRUCT(BlueprintType)
@@ -61,10 +68,14 @@ public:
 	TSubclassOf<ADefaultItem> itemToCollect;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
-	FString description;
+	FText description;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	int numRequired;
+
+	//Progress so far, moved on by AdvanceObjective
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int numCompleted = 0;
 };
 
 
@@ -77,19 +88,28 @@ class FIRSTRPG_API UBaseQuest : public UObject
 
 public:
 	UFUNCTION(BlueprintCallable)
-	void SetQuestDetails(FString _name, FString _description);
+	void SetQuestDetails(FName _questId, FText _displayName, FText _description);
 
 	UFUNCTION(BlueprintCallable)
-	void SetUpObjective(int _objectiveNum, TSubclassOf<AMyActor> _enemy, TSubclassOf<ADefaultItem> _item, FString _description, int _numRequired);
+	void SetUpObjective(int _objectiveNum, TSubclassOf<AMyActor> _enemy, TSubclassOf<ADefaultItem> _item, FText _description, int _numRequired);
 
 	UFUNCTION(BlueprintCallable)
 	void SetNumObjectives(int _numObjectives);
 
+	//Counts progress on an objective (a kill, an item collected). Returns true once it is complete.
+	UFUNCTION(BlueprintCallable)
+	bool AdvanceObjective(int _objectiveNum, int _amount = 1);
+
+	//Identifies the quest; compare these rather than display text
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FName questId;
+
+	//Display text, normally keys into the shared FirstRPG.Quests string table
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
-	FString name;
+	FText displayName;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
-	FString description;
+	FText description;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	FReward reward;
@@ -0,0 +1,736 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DamageFormula.h"
+#include "FirstRPG.h"
+
+//////////////////////////////////////////////////////////////////////////
+// Parsing
+
+namespace
+{
+	struct FNamedValue
+	{
+		const TCHAR* name;
+		float value;
+	};
+
+	const TCHAR* const VariableNames[(int32)EDamageVariable::Count] =
+	{
+		TEXT("strength"),
+		TEXT("dexterity"),
+		TEXT("attackSpeed"),
+		TEXT("level"),
+		TEXT("baseDamage"),
+		TEXT("baseSpeed"),
+		TEXT("levelReq"),
+		TEXT("weaponType")
+	};
+
+	const FNamedValue NamedConstants[] =
+	{
+		{ TEXT("DEFAULT"), (float)EWeaponType::E_Default },
+		{ TEXT("SWORD"), (float)EWeaponType::E_Sword },
+		{ TEXT("DAGGER"), (float)EWeaponType::E_Dagger },
+		{ TEXT("AXE"), (float)EWeaponType::E_Axe }
+	};
+
+	//How many operands each opcode pops
+	int32 NumOperands(EDamageOpCode _code)
+	{
+		switch (_code)
+		{
+		case EDamageOpCode::PushVariable:
+		case EDamageOpCode::PushConstant:
+			return 0;
+		case EDamageOpCode::Negate:
+		case EDamageOpCode::Sqrt:
+		case EDamageOpCode::Floor:
+			return 1;
+		case EDamageOpCode::Clamp:
+		case EDamageOpCode::Select:
+			return 3;
+		default:
+			return 2;
+		}
+	}
+
+	float ApplyUnary(EDamageOpCode _code, float _x)
+	{
+		switch (_code)
+		{
+		case EDamageOpCode::Negate:		return -_x;
+		case EDamageOpCode::Sqrt:		return FMath::Sqrt(FMath::Max(_x, 0.0f));
+		default:						return FMath::FloorToFloat(_x);
+		}
+	}
+
+	float ApplyBinary(EDamageOpCode _code, float _a, float _b)
+	{
+		switch (_code)
+		{
+		case EDamageOpCode::Add:			return _a + _b;
+		case EDamageOpCode::Subtract:		return _a - _b;
+		case EDamageOpCode::Multiply:		return _a * _b;
+		case EDamageOpCode::Divide:			return _b != 0.0f ? _a / _b : 0.0f;
+		case EDamageOpCode::Power:			return FMath::Pow(_a, _b);
+		case EDamageOpCode::Min:			return FMath::Min(_a, _b);
+		case EDamageOpCode::Max:			return FMath::Max(_a, _b);
+		case EDamageOpCode::Less:			return _a < _b ? 1.0f : 0.0f;
+		case EDamageOpCode::Greater:		return _a > _b ? 1.0f : 0.0f;
+		case EDamageOpCode::LessEqual:		return _a <= _b ? 1.0f : 0.0f;
+		case EDamageOpCode::GreaterEqual:	return _a >= _b ? 1.0f : 0.0f;
+		case EDamageOpCode::Equal:			return _a == _b ? 1.0f : 0.0f;
+		default:							return _a != _b ? 1.0f : 0.0f;
+		}
+	}
+
+	float ApplyTernary(EDamageOpCode _code, float _a, float _b, float _c)
+	{
+		if (_code == EDamageOpCode::Clamp)
+		{
+			return FMath::Clamp(_a, _b, _c);
+		}
+		return _a != 0.0f ? _b : _c;
+	}
+
+	//Recursive-descent parser emitting postfix bytecode, folding constant subexpressions as it goes
+	class FDamageFormulaParser
+	{
+	public:
+		FDamageFormulaParser(const FString& _source, TArray<FDamageOp>& _outCode)
+			: source(_source), code(_outCode)
+		{
+		}
+
+		bool Parse(FString& _outError)
+		{
+			if (ParseConditional())
+			{
+				SkipWhitespace();
+				if (pos < source.Len())
+				{
+					Fail(TEXT("unexpected character"));
+				}
+			}
+
+			if (!error.IsEmpty())
+			{
+				_outError = FString::Printf(TEXT("%s at column %d"), *error, pos + 1);
+				return false;
+			}
+			return true;
+		}
+
+	private:
+		// cond := compare ('?' cond ':' cond)?
+		bool ParseConditional()
+		{
+			if (!ParseComparison())
+			{
+				return false;
+			}
+			if (Match(TEXT("?")))
+			{
+				if (!ParseConditional() || !Expect(TEXT(":")) || !ParseConditional())
+				{
+					return false;
+				}
+				Emit(EDamageOpCode::Select);
+			}
+			return true;
+		}
+
+		// compare := additive (op additive)?
+		bool ParseComparison()
+		{
+			if (!ParseAdditive())
+			{
+				return false;
+			}
+
+			//Two-character operators first so "<=" is not read as "<"
+			static const TPair<const TCHAR*, EDamageOpCode> operators[] =
+			{
+				{ TEXT("<="), EDamageOpCode::LessEqual },
+				{ TEXT(">="), EDamageOpCode::GreaterEqual },
+				{ TEXT("=="), EDamageOpCode::Equal },
+				{ TEXT("!="), EDamageOpCode::NotEqual },
+				{ TEXT("<"), EDamageOpCode::Less },
+				{ TEXT(">"), EDamageOpCode::Greater }
+			};
+			for (const TPair<const TCHAR*, EDamageOpCode>& op : operators)
+			{
+				if (Match(op.Key))
+				{
+					if (!ParseAdditive())
+					{
+						return false;
+					}
+					Emit(op.Value);
+					break;
+				}
+			}
+			return true;
+		}
+
+		// additive := term (('+' | '-') term)*
+		bool ParseAdditive()
+		{
+			if (!ParseTerm())
+			{
+				return false;
+			}
+			while (true)
+			{
+				const EDamageOpCode op = Match(TEXT("+")) ? EDamageOpCode::Add : Match(TEXT("-")) ? EDamageOpCode::Subtract : EDamageOpCode::PushConstant;
+				if (op == EDamageOpCode::PushConstant)
+				{
+					return true;
+				}
+				if (!ParseTerm())
+				{
+					return false;
+				}
+				Emit(op);
+			}
+		}
+
+		// term := unary (('*' | '/') unary)*
+		bool ParseTerm()
+		{
+			if (!ParseUnary())
+			{
+				return false;
+			}
+			while (true)
+			{
+				const EDamageOpCode op = Match(TEXT("*")) ? EDamageOpCode::Multiply : Match(TEXT("/")) ? EDamageOpCode::Divide : EDamageOpCode::PushConstant;
+				if (op == EDamageOpCode::PushConstant)
+				{
+					return true;
+				}
+				if (!ParseUnary())
+				{
+					return false;
+				}
+				Emit(op);
+			}
+		}
+
+		// unary := '-' unary | power
+		bool ParseUnary()
+		{
+			if (Match(TEXT("-")))
+			{
+				if (!ParseUnary())
+				{
+					return false;
+				}
+				Emit(EDamageOpCode::Negate);
+				return true;
+			}
+			return ParsePower();
+		}
+
+		// power := primary ('^' unary)?   (right associative)
+		bool ParsePower()
+		{
+			if (!ParsePrimary())
+			{
+				return false;
+			}
+			if (Match(TEXT("^")))
+			{
+				if (!ParseUnary())
+				{
+					return false;
+				}
+				Emit(EDamageOpCode::Power);
+			}
+			return true;
+		}
+
+		// primary := number | name | function '(' args ')' | '(' cond ')'
+		bool ParsePrimary()
+		{
+			SkipWhitespace();
+			if (pos >= source.Len())
+			{
+				return Fail(TEXT("unexpected end of formula"));
+			}
+
+			if (Match(TEXT("(")))
+			{
+				return ParseConditional() && Expect(TEXT(")"));
+			}
+
+			const TCHAR first = source[pos];
+			if (FChar::IsDigit(first) || first == TEXT('.'))
+			{
+				const int32 start = pos;
+				while (pos < source.Len() && (FChar::IsDigit(source[pos]) || source[pos] == TEXT('.')))
+				{
+					pos++;
+				}
+				EmitConstant(FCString::Atof(*source.Mid(start, pos - start)));
+				return true;
+			}
+
+			if (FChar::IsAlpha(first) || first == TEXT('_'))
+			{
+				const int32 start = pos;
+				while (pos < source.Len() && (FChar::IsAlnum(source[pos]) || source[pos] == TEXT('_')))
+				{
+					pos++;
+				}
+				return ParseName(source.Mid(start, pos - start));
+			}
+
+			return Fail(TEXT("expected a number, name or '('"));
+		}
+
+		bool ParseName(const FString& _name)
+		{
+			for (int32 i = 0; i < (int32)EDamageVariable::Count; i++)
+			{
+				if (_name == VariableNames[i])
+				{
+					FDamageOp& op = code.AddDefaulted_GetRef();
+					op.code = EDamageOpCode::PushVariable;
+					op.variable = (EDamageVariable)i;
+					op.constant = 0.0f;
+					return true;
+				}
+			}
+
+			for (const FNamedValue& named : NamedConstants)
+			{
+				if (_name == named.name)
+				{
+					EmitConstant(named.value);
+					return true;
+				}
+			}
+
+			static const TPair<const TCHAR*, EDamageOpCode> functions[] =
+			{
+				{ TEXT("min"), EDamageOpCode::Min },
+				{ TEXT("max"), EDamageOpCode::Max },
+				{ TEXT("clamp"), EDamageOpCode::Clamp },
+				{ TEXT("sqrt"), EDamageOpCode::Sqrt },
+				{ TEXT("floor"), EDamageOpCode::Floor }
+			};
+			for (const TPair<const TCHAR*, EDamageOpCode>& function : functions)
+			{
+				if (_name == function.Key)
+				{
+					if (!Expect(TEXT("(")))
+					{
+						return false;
+					}
+					const int32 numArgs = NumOperands(function.Value);
+					for (int32 arg = 0; arg < numArgs; arg++)
+					{
+						if ((arg > 0 && !Expect(TEXT(","))) || !ParseConditional())
+						{
+							return false;
+						}
+					}
+					if (!Expect(TEXT(")")))
+					{
+						return false;
+					}
+					Emit(function.Value);
+					return true;
+				}
+			}
+
+			return Fail(FString::Printf(TEXT("unknown name '%s'"), *_name));
+		}
+
+		void EmitConstant(float _value)
+		{
+			FDamageOp& op = code.AddDefaulted_GetRef();
+			op.code = EDamageOpCode::PushConstant;
+			op.variable = EDamageVariable::Count;
+			op.constant = _value;
+		}
+
+		//Emits an operator, or folds it straight into a constant when all its operands are constants
+		void Emit(EDamageOpCode _code)
+		{
+			const int32 numOperands = NumOperands(_code);
+			bool allConstant = code.Num() >= numOperands;
+			for (int32 i = 1; i <= numOperands && allConstant; i++)
+			{
+				allConstant = code[code.Num() - i].code == EDamageOpCode::PushConstant;
+			}
+
+			if (!allConstant)
+			{
+				FDamageOp& op = code.AddDefaulted_GetRef();
+				op.code = _code;
+				op.variable = EDamageVariable::Count;
+				op.constant = 0.0f;
+				return;
+			}
+
+			float value;
+			const int32 last = code.Num() - 1;
+			if (numOperands == 1)
+			{
+				value = ApplyUnary(_code, code[last].constant);
+			}
+			else if (numOperands == 2)
+			{
+				value = ApplyBinary(_code, code[last - 1].constant, code[last].constant);
+			}
+			else
+			{
+				value = ApplyTernary(_code, code[last - 2].constant, code[last - 1].constant, code[last].constant);
+			}
+			code.SetNum(code.Num() - numOperands, false);
+			EmitConstant(value);
+		}
+
+		void SkipWhitespace()
+		{
+			while (pos < source.Len() && FChar::IsWhitespace(source[pos]))
+			{
+				pos++;
+			}
+		}
+
+		bool Match(const TCHAR* _token)
+		{
+			SkipWhitespace();
+			const int32 length = FCString::Strlen(_token);
+			if (FCString::Strncmp(*source + pos, _token, length) == 0)
+			{
+				pos += length;
+				return true;
+			}
+			return false;
+		}
+
+		bool Expect(const TCHAR* _token)
+		{
+			return Match(_token) || Fail(FString::Printf(TEXT("expected '%s'"), _token));
+		}
+
+		bool Fail(const FString& _message)
+		{
+			if (error.IsEmpty())
+			{
+				error = _message;
+			}
+			return false;
+		}
+
+		const FString& source;
+		TArray<FDamageOp>& code;
+		int32 pos = 0;
+		FString error;
+	};
+
+	//An evaluation stack entry: either one constant for every hit or a column of per-hit values
+	struct FStackSlot
+	{
+		const float* lanes;
+		float constant;
+		bool isConstant;
+
+		float Lane(int32 _index) const { return isConstant ? constant : lanes[_index]; }
+	};
+
+	//The three loops are split so the common column-op-column and column-op-constant cases stay branch-free
+	template <typename OpType>
+	void RunBinary(FStackSlot& _a, const FStackSlot& _b, float* _out, int32 _numHits, OpType _op)
+	{
+		if (_a.isConstant)
+		{
+			for (int32 i = 0; i < _numHits; i++)
+			{
+				_out[i] = _op(_a.constant, _b.lanes[i]);
+			}
+		}
+		else if (_b.isConstant)
+		{
+			for (int32 i = 0; i < _numHits; i++)
+			{
+				_out[i] = _op(_a.lanes[i], _b.constant);
+			}
+		}
+		else
+		{
+			for (int32 i = 0; i < _numHits; i++)
+			{
+				_out[i] = _op(_a.lanes[i], _b.lanes[i]);
+			}
+		}
+		_a.lanes = _out;
+		_a.isConstant = false;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FDamageInputBatch
+
+void FDamageInputBatch::Reset(int _expectedHits)
+{
+	for (TArray<float>& column : columns)
+	{
+		column.Reset(_expectedHits);
+	}
+}
+
+void FDamageInputBatch::AddHit(const FDamageHitInput& _hit)
+{
+	columns[(int32)EDamageVariable::Strength].Add((float)_hit.strength);
+	columns[(int32)EDamageVariable::Dexterity].Add((float)_hit.dexterity);
+	columns[(int32)EDamageVariable::AttackSpeed].Add(_hit.attackSpeed);
+	columns[(int32)EDamageVariable::Level].Add((float)_hit.level);
+	columns[(int32)EDamageVariable::BaseDamage].Add(_hit.baseDamage);
+	columns[(int32)EDamageVariable::BaseSpeed].Add(_hit.baseSpeed);
+	columns[(int32)EDamageVariable::LevelReq].Add((float)_hit.levelReq);
+	columns[(int32)EDamageVariable::WeaponType].Add((float)_hit.weaponType);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// UDamageFormula
+
+void UDamageFormula::PostLoad()
+{
+	Super::PostLoad();
+
+	FString error;
+	if (!Compile(error))
+	{
+		UE_LOG(LogFirstRPG, Warning, TEXT("Damage formula '%s' failed to compile: %s"), *GetPathName(), *error);
+	}
+}
+
+#if WITH_EDITOR
+void UDamageFormula::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	FString error;
+	if (!Compile(error))
+	{
+		UE_LOG(LogFirstRPG, Warning, TEXT("Damage formula '%s' failed to compile: %s"), *GetPathName(), *error);
+	}
+}
+#endif
+
+bool UDamageFormula::Compile(FString& _outError)
+{
+	bytecode.Reset();
+	maxStackDepth = 0;
+
+	//No formula yet, so hits just deal the weapon's base damage
+	if (expression.TrimStartAndEnd().IsEmpty())
+	{
+		return true;
+	}
+
+	TArray<FDamageOp> compiled;
+	FDamageFormulaParser parser(expression, compiled);
+	if (!parser.Parse(_outError))
+	{
+		return false;
+	}
+
+	int32 depth = 0;
+	for (const FDamageOp& op : compiled)
+	{
+		const int32 numOperands = NumOperands(op.code);
+		depth += numOperands == 0 ? 1 : 1 - numOperands;
+		maxStackDepth = FMath::Max(maxStackDepth, depth);
+	}
+	check(depth == 1);
+
+	bytecode = MoveTemp(compiled);
+	return true;
+}
+
+void UDamageFormula::EvaluateBatch(const FDamageInputBatch& _inputs, TArrayView<float> _outDamage) const
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UDamageFormula::EvaluateBatch);
+
+	const int32 numHits = _inputs.Num();
+	check(_outDamage.Num() >= numHits);
+
+	if (!IsCompiled())
+	{
+		FMemory::Memcpy(_outDamage.GetData(), _inputs.GetColumn(EDamageVariable::BaseDamage), numHits * sizeof(float));
+		return;
+	}
+
+	//One scratch column per stack depth; an operator writes its result into its left operand's column
+	TArray<float> scratch;
+	scratch.SetNumUninitialized(maxStackDepth * numHits);
+	TArray<FStackSlot, TInlineAllocator<16>> stack;
+
+	for (const FDamageOp& op : bytecode)
+	{
+		switch (op.code)
+		{
+		case EDamageOpCode::PushVariable:
+			stack.Add({ _inputs.GetColumn(op.variable), 0.0f, false });
+			break;
+
+		case EDamageOpCode::PushConstant:
+			stack.Add({ nullptr, op.constant, true });
+			break;
+
+		case EDamageOpCode::Negate:
+		case EDamageOpCode::Sqrt:
+		case EDamageOpCode::Floor:
+		{
+			FStackSlot& x = stack.Last();
+			float* out = scratch.GetData() + (stack.Num() - 1) * numHits;
+			for (int32 i = 0; i < numHits; i++)
+			{
+				out[i] = ApplyUnary(op.code, x.Lane(i));
+			}
+			x.lanes = out;
+			x.isConstant = false;
+			break;
+		}
+
+		case EDamageOpCode::Clamp:
+		case EDamageOpCode::Select:
+		{
+			const FStackSlot c = stack.Pop(false);
+			const FStackSlot b = stack.Pop(false);
+			FStackSlot& a = stack.Last();
+			float* out = scratch.GetData() + (stack.Num() - 1) * numHits;
+			for (int32 i = 0; i < numHits; i++)
+			{
+				out[i] = ApplyTernary(op.code, a.Lane(i), b.Lane(i), c.Lane(i));
+			}
+			a.lanes = out;
+			a.isConstant = false;
+			break;
+		}
+
+		default:
+		{
+			const FStackSlot b = stack.Pop(false);
+			FStackSlot& a = stack.Last();
+			float* out = scratch.GetData() + (stack.Num() - 1) * numHits;
+
+			//The hot arithmetic gets its own loops; the rest share the generic one
+			switch (op.code)
+			{
+			case EDamageOpCode::Add:
+				RunBinary(a, b, out, numHits, [](float _x, float _y) { return _x + _y; });
+				break;
+			case EDamageOpCode::Subtract:
+				RunBinary(a, b, out, numHits, [](float _x, float _y) { return _x - _y; });
+				break;
+			case EDamageOpCode::Multiply:
+				RunBinary(a, b, out, numHits, [](float _x, float _y) { return _x * _y; });
+				break;
+			default:
+			{
+				const EDamageOpCode code = op.code;
+				RunBinary(a, b, out, numHits, [code](float _x, float _y) { return ApplyBinary(code, _x, _y); });
+				break;
+			}
+			}
+			break;
+		}
+		}
+	}
+
+	//Folding leaves a lone constant when the formula reads no variables
+	const FStackSlot& result = stack.Last();
+	if (result.isConstant)
+	{
+		for (int32 i = 0; i < numHits; i++)
+		{
+			_outDamage[i] = result.constant;
+		}
+	}
+	else
+	{
+		FMemory::Memcpy(_outDamage.GetData(), result.lanes, numHits * sizeof(float));
+	}
+}
+
+TArray<float> UDamageFormula::EvaluateHits(const TArray<FDamageHitInput>& _hits) const
+{
+	FDamageInputBatch batch;
+	batch.Reset(_hits.Num());
+	for (const FDamageHitInput& hit : _hits)
+	{
+		batch.AddHit(hit);
+	}
+
+	TArray<float> damage;
+	damage.SetNumUninitialized(_hits.Num());
+	EvaluateBatch(batch, damage);
+	return damage;
+}
+
+float UDamageFormula::EvaluateHit(const FDamageHitInput& _hit) const
+{
+	if (!IsCompiled())
+	{
+		return _hit.baseDamage;
+	}
+
+	float variables[(int32)EDamageVariable::Count];
+	variables[(int32)EDamageVariable::Strength] = (float)_hit.strength;
+	variables[(int32)EDamageVariable::Dexterity] = (float)_hit.dexterity;
+	variables[(int32)EDamageVariable::AttackSpeed] = _hit.attackSpeed;
+	variables[(int32)EDamageVariable::Level] = (float)_hit.level;
+	variables[(int32)EDamageVariable::BaseDamage] = _hit.baseDamage;
+	variables[(int32)EDamageVariable::BaseSpeed] = _hit.baseSpeed;
+	variables[(int32)EDamageVariable::LevelReq] = (float)_hit.levelReq;
+	variables[(int32)EDamageVariable::WeaponType] = (float)_hit.weaponType;
+
+	//Only a formula nested deeper than the inline registers would spill to the heap
+	TArray<float, TInlineAllocator<16>> stack;
+
+	for (const FDamageOp& op : bytecode)
+	{
+		switch (op.code)
+		{
+		case EDamageOpCode::PushVariable:
+			stack.Add(variables[(int32)op.variable]);
+			break;
+
+		case EDamageOpCode::PushConstant:
+			stack.Add(op.constant);
+			break;
+
+		case EDamageOpCode::Negate:
+		case EDamageOpCode::Sqrt:
+		case EDamageOpCode::Floor:
+			stack.Last() = ApplyUnary(op.code, stack.Last());
+			break;
+
+		case EDamageOpCode::Clamp:
+		case EDamageOpCode::Select:
+		{
+			const float c = stack.Pop(false);
+			const float b = stack.Pop(false);
+			stack.Last() = ApplyTernary(op.code, stack.Last(), b, c);
+			break;
+		}
+
+		default:
+		{
+			const float b = stack.Pop(false);
+			stack.Last() = ApplyBinary(op.code, stack.Last(), b);
+			break;
+		}
+		}
+	}
+
+	return stack.Last();
+}
@@ -0,0 +1,158 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "DefaultWeapon.h"
+#include "DamageFormula.generated.h"
+
+/**
+ * Designer-editable damage formula, e.g.
+ *
+ *     baseDamage * (1 + strength * 0.1) * (weaponType == DAGGER ? 1 + dexterity * 0.05 : 1) / max(baseSpeed, 0.1)
+ *
+ * The expression is compiled to a small stack bytecode when the asset loads. Evaluation runs each
+ * instruction across a whole batch of hits before moving to the next, so the per-hit cost is a few
+ * tight loops over packed floats rather than a graph walk per hit. A single hit runs the same
+ * bytecode over a stack of plain floats instead, without packing a batch.
+ *
+ * Variables: strength, dexterity, attackSpeed, level, baseDamage, baseSpeed, levelReq, weaponType
+ * Constants: DEFAULT, SWORD, DAGGER, AXE (weapon types)
+ * Operators: + - * / ^, comparisons (< > <= >= == !=) giving 1 or 0, and cond ? a : b
+ * Functions: min(a, b), max(a, b), clamp(x, lo, hi), sqrt(x), floor(x)
+ *
+ * Dividing by zero gives 0 rather than inf or NaN, and sqrt of a negative number gives 0.
+ */
+
+//Inputs a formula can read, one packed column each
+enum class EDamageVariable : uint8
+{
+	Strength,
+	Dexterity,
+	AttackSpeed,
+	Level,
+	BaseDamage,
+	BaseSpeed,
+	LevelReq,
+	WeaponType,
+	Count
+};
+
+enum class EDamageOpCode : uint8
+{
+	PushVariable,
+	PushConstant,
+	Add,
+	Subtract,
+	Multiply,
+	Divide,
+	Power,
+	Min,
+	Max,
+	Less,
+	Greater,
+	LessEqual,
+	GreaterEqual,
+	Equal,
+	NotEqual,
+	Negate,
+	Sqrt,
+	Floor,
+	Clamp,
+	Select
+};
+
+struct FDamageOp
+{
+	EDamageOpCode code;
+	EDamageVariable variable;
+	float constant;
+};
+
+//One hit's worth of inputs, for Blueprint callers
+USTRUCT(BlueprintType)
+struct FDamageHitInput
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int strength = 1;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int dexterity = 1;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float attackSpeed = 1.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int level = 1;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float baseDamage = 0.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float baseSpeed = 1.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int levelReq = 1;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	EWeaponType weaponType = EWeaponType::E_Default;
+};
+
+//Hits packed column-wise so each instruction streams through contiguous floats
+struct FIRSTRPG_API FDamageInputBatch
+{
+	void Reset(int _expectedHits = 0);
+	void AddHit(const FDamageHitInput& _hit);
+	int Num() const { return columns[0].Num(); }
+
+	const float* GetColumn(EDamageVariable _variable) const { return columns[(int32)_variable].GetData(); }
+	TArray<float>& GetColumnMutable(EDamageVariable _variable) { return columns[(int32)_variable]; }
+
+private:
+	TArray<float> columns[(int32)EDamageVariable::Count];
+};
+
+UCLASS(BlueprintType)
+class FIRSTRPG_API UDamageFormula : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	virtual void PostLoad() override;
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+	//Compiles expression. Until it compiles (or while it is empty) the formula returns baseDamage.
+	bool Compile(FString& _outError);
+
+	bool IsCompiled() const { return bytecode.Num() > 0; }
+
+	//Writes one damage value per hit into _outDamage, which must hold at least _inputs.Num() values
+	void EvaluateBatch(const FDamageInputBatch& _inputs, TArrayView<float> _outDamage) const;
+
+	//Blueprint entry point; packs the hits and evaluates them in one pass
+	UFUNCTION(BlueprintCallable, Category = "Damage")
+	TArray<float> EvaluateHits(const TArray<FDamageHitInput>& _hits) const;
+
+	//One hit, evaluated on the stack with no heap allocation; what ComputeHitDamage uses per punch
+	UFUNCTION(BlueprintCallable, Category = "Damage")
+	float EvaluateHit(const FDamageHitInput& _hit) const;
+
+	//Compiled instructions, for tests and debugging
+	TArrayView<const FDamageOp> GetBytecode() const { return bytecode; }
+
+	//The formula designers edit
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Damage", meta = (MultiLine = true))
+	FString expression;
+
+private:
+	TArray<FDamageOp> bytecode;
+
+	//Deepest the evaluation stack gets, which sizes the scratch columns
+	int maxStackDepth = 0;
+};
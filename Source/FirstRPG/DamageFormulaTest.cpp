@@ -0,0 +1,92 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "DamageFormula.h"
+
+//Compiles _expression into _formula, failing the test with the parser's message if it does not compile
+static bool CompileFormula(FAutomationTestBase& _test, UDamageFormula* _formula, const TCHAR* _expression)
+{
+	_formula->expression = _expression;
+	FString error;
+	const bool compiled = _formula->Compile(error);
+	_test.TestTrue(FString::Printf(TEXT("'%s' compiles (%s)"), _expression, *error), compiled);
+	return compiled;
+}
+
+//Precedence, associativity and constant folding of the formula compiler, checked through both evaluation paths
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDamageFormulaCompileTest, "FirstRPG.Damage.FormulaCompile",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ProductFilter)
+
+bool FDamageFormulaCompileTest::RunTest(const FString& Parameters)
+{
+	UDamageFormula* formula = NewObject<UDamageFormula>();
+
+	FDamageHitInput hit;
+	hit.strength = 4;
+	hit.dexterity = 2;
+	hit.baseDamage = 5.0f;
+	hit.baseSpeed = 2.0f;
+	hit.weaponType = EWeaponType::E_Dagger;
+
+	struct FExpected
+	{
+		const TCHAR* expression;
+		float value;
+		int32 numOps;
+	};
+
+	//numOps 1 means the whole formula folded into one constant
+	const FExpected cases[] =
+	{
+		{ TEXT("2 + 3 * 4"), 14.0f, 1 },
+		{ TEXT("(2 + 3) * 4"), 20.0f, 1 },
+		{ TEXT("10 - 4 - 3"), 3.0f, 1 },
+		{ TEXT("2 ^ 3 ^ 2"), 512.0f, 1 },
+		{ TEXT("-2 ^ 2"), -4.0f, 1 },
+		{ TEXT("1 + 2 < 4 ? 10 : 20"), 10.0f, 1 },
+		{ TEXT("1 ? 2 : 0 ? 3 : 4"), 2.0f, 1 },
+		{ TEXT("clamp(7, 0, 5) + min(1, 2) * max(3, 4)"), 9.0f, 1 },
+		{ TEXT("10 / 0"), 0.0f, 1 },
+		{ TEXT("baseDamage / 0"), 0.0f, 3 },
+		{ TEXT("baseDamage * (2 + 3)"), 25.0f, 3 },
+		{ TEXT("baseDamage * 2 + 1"), 11.0f, 5 },
+		{ TEXT("baseDamage + strength * dexterity"), 13.0f, 5 },
+		{ TEXT("weaponType == DAGGER ? baseDamage * (1 + dexterity * 0.5) : baseDamage"), 10.0f, 12 }
+	};
+
+	for (const FExpected& expected : cases)
+	{
+		if (!CompileFormula(*this, formula, expected.expression))
+		{
+			continue;
+		}
+
+		TestEqual(FString::Printf(TEXT("'%s' instruction count"), expected.expression), formula->GetBytecode().Num(), expected.numOps);
+		TestEqual(FString::Printf(TEXT("'%s' single hit"), expected.expression), formula->EvaluateHit(hit), expected.value);
+
+		FDamageInputBatch batch;
+		batch.AddHit(hit);
+		batch.AddHit(hit);
+		float damage[2] = { -1.0f, -1.0f };
+		formula->EvaluateBatch(batch, MakeArrayView(damage, 2));
+		TestEqual(FString::Printf(TEXT("'%s' batch"), expected.expression), damage[1], expected.value);
+	}
+
+	//Malformed formulas are rejected, and the formula falls back to base damage
+	const TCHAR* const malformed[] = { TEXT("1 +"), TEXT("(1 + 2"), TEXT("foo * 2"), TEXT("min(1)"), TEXT("2 $ 3") };
+	for (const TCHAR* expression : malformed)
+	{
+		formula->expression = expression;
+		FString error;
+		TestFalse(FString::Printf(TEXT("'%s' is rejected"), expression), formula->Compile(error));
+		TestEqual(FString::Printf(TEXT("'%s' falls back to base damage"), expression), formula->EvaluateHit(hit), hit.baseDamage);
+	}
+
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
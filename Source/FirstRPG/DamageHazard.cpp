@@ -0,0 +1,142 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DamageHazard.h"
+#include "FirstRPG.h"
+#include "FirstRPGCharacter.h"
+#include "Components/BoxComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "TimerManager.h"
+
+// Sets default values
+ADamageHazard::ADamageHazard()
+{
+	LLM_SCOPE_BYTAG(FirstRPG_Items);
+
+	//Damage over time runs on a timer while someone is inside
+	PrimaryActorTick.bCanEverTick = false;
+
+	hazardBox = CreateDefaultSubobject<UBoxComponent>(TEXT("HazardBox"));
+	hazardBox->InitBoxExtent(FVector(50.0f, 50.0f, 25.0f));
+	hazardBox->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+	hazardBox->SetCollisionObjectType(ECC_Pickup);
+	hazardBox->SetCollisionResponseToAllChannels(ECR_Ignore);
+	hazardBox->SetCollisionResponseToChannel(ECC_Pawn, ECR_Overlap);
+	hazardBox->SetGenerateOverlapEvents(true);
+	RootComponent = hazardBox;
+
+	mesh = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("Mesh"));
+	mesh->SetupAttachment(hazardBox);
+	mesh->SetGenerateOverlapEvents(false);
+
+	damageAmount = 0.1f;
+	damageInterval = 1.0f;
+
+	//Hurt a player already standing where the hazard streams in, not only one who walks in later
+	bGenerateOverlapEventsDuringLevelStreaming = true;
+}
+
+void ADamageHazard::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	hazardBox->OnComponentBeginOverlap.AddDynamic(this, &ADamageHazard::OnBoxBeginOverlap);
+	hazardBox->OnComponentEndOverlap.AddDynamic(this, &ADamageHazard::OnBoxEndOverlap);
+}
+
+void ADamageHazard::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	GetWorldTimerManager().ClearAllTimersForObject(this);
+	victims.Empty();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ADamageHazard::OnBoxBeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
+{
+	AFirstRPGCharacter* victim = Cast<AFirstRPGCharacter>(OtherActor);
+	if (victim == nullptr)
+	{
+		return;
+	}
+
+	FHazardVictim& state = victims.FindOrAdd(victim);
+	GetWorldTimerManager().ClearTimer(state.timer);
+
+	//Hit on entry unless the victim is still cooling down from a visit moments ago, then every interval after that
+	const float interval = FMath::Max(damageInterval, 0.05f);
+	const float cooldownLeft = GetCooldownLeft(state);
+	FTimerDelegate hit = FTimerDelegate::CreateUObject(this, &ADamageHazard::DamageVictim, TWeakObjectPtr<AFirstRPGCharacter>(victim));
+	GetWorldTimerManager().SetTimer(state.timer, hit, interval, true, cooldownLeft > 0.0f ? cooldownLeft : interval);
+
+	//Last, as the damage may end the overlap and drop this entry
+	if (cooldownLeft <= 0.0f)
+	{
+		TryDamage(victim, state);
+	}
+}
+
+void ADamageHazard::OnBoxEndOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex)
+{
+	const TWeakObjectPtr<AFirstRPGCharacter> victim = Cast<AFirstRPGCharacter>(OtherActor);
+	FHazardVictim* state = victims.Find(victim);
+	if (state == nullptr)
+	{
+		return;
+	}
+
+	GetWorldTimerManager().ClearTimer(state->timer);
+
+	//Keep the entry only as long as its cooldown still matters
+	const float cooldownLeft = GetCooldownLeft(*state);
+	if (cooldownLeft <= 0.0f)
+	{
+		victims.Remove(victim);
+		return;
+	}
+
+	FTimerDelegate forget = FTimerDelegate::CreateUObject(this, &ADamageHazard::ForgetVictim, victim);
+	GetWorldTimerManager().SetTimer(state->timer, forget, cooldownLeft, false);
+}
+
+void ADamageHazard::DamageVictim(TWeakObjectPtr<AFirstRPGCharacter> _victim)
+{
+	FHazardVictim* state = victims.Find(_victim);
+	if (state == nullptr)
+	{
+		return;
+	}
+
+	if (AFirstRPGCharacter* victim = _victim.Get())
+	{
+		TryDamage(victim, *state);
+		return;
+	}
+
+	//Destroyed while inside, so no end overlap will come
+	GetWorldTimerManager().ClearTimer(state->timer);
+	victims.Remove(_victim);
+}
+
+void ADamageHazard::ForgetVictim(TWeakObjectPtr<AFirstRPGCharacter> _victim)
+{
+	victims.Remove(_victim);
+}
+
+void ADamageHazard::TryDamage(AFirstRPGCharacter* _victim, FHazardVictim& _state)
+{
+	if (GetCooldownLeft(_state) > 0.0f)
+	{
+		return;
+	}
+
+	_state.lastHitTime = GetWorld()->GetTimeSeconds();
+	_victim->TakeDamage(damageAmount);
+}
+
+float ADamageHazard::GetCooldownLeft(const FHazardVictim& _state) const
+{
+	//A small tolerance so a timer firing a hair early still counts as a full interval
+	const float cooldownLeft = _state.lastHitTime + damageInterval - GetWorld()->GetTimeSeconds();
+	return cooldownLeft > KINDA_SMALL_NUMBER ? cooldownLeft : 0.0f;
+}
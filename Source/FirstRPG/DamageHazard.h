@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "DamageHazard.generated.h"
+
+class UBoxComponent;
+class UStaticMeshComponent;
+class AFirstRPGCharacter;
+
+/**
+ * Damages the player while they stand in it, at most once per damageInterval per victim.
+ * Uses the Pickup channel like ABaseCollectible and a timer per victim instead of Tick, so the
+ * first hit lands on entry and each victim is then hit on its own interval.
+ */
+UCLASS()
+class FIRSTRPG_API ADamageHazard : public AActor
+{
+	GENERATED_BODY()
+	
+public:	
+	// Sets default values for this actor's properties
+	ADamageHazard();
+
+protected:
+	//Binds the overlap events before initial overlaps are dispatched, which happens ahead of BeginPlay
+	virtual void PostInitializeComponents() override;
+
+	// Called when the actor is destroyed or its level streams out
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	UFUNCTION()
+	void OnBoxBeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
+
+	UFUNCTION()
+	void OnBoxEndOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex);
+
+	//Timer callback for one victim while it stays inside
+	void DamageVictim(TWeakObjectPtr<AFirstRPGCharacter> _victim);
+
+	//Drops a victim that left once its cooldown has run out
+	void ForgetVictim(TWeakObjectPtr<AFirstRPGCharacter> _victim);
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Hazard")
+	UBoxComponent* hazardBox;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Hazard")
+	UStaticMeshComponent* mesh;
+
+	//Damage dealt per hit
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hazard")
+	float damageAmount;
+
+	//Seconds between hits on the same victim
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hazard")
+	float damageInterval;
+
+private:
+	struct FHazardVictim
+	{
+		//Repeating hit while inside; after leaving, a one-shot that forgets the victim
+		FTimerHandle timer;
+
+		//World seconds of the last hit
+		float lastHitTime = -MAX_flt;
+	};
+
+	//Damages a victim unless it was hit less than damageInterval ago
+	void TryDamage(AFirstRPGCharacter* _victim, FHazardVictim& _state);
+
+	//Seconds until the victim may be hit again, 0 if it may be hit now
+	float GetCooldownLeft(const FHazardVictim& _state) const;
+
+	//Players inside, plus those that left less than damageInterval ago so stepping out and back
+	//in cannot skip the rate limit
+	TMap<TWeakObjectPtr<AFirstRPGCharacter>, FHazardVictim> victims;
+};
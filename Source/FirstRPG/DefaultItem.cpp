@@ -2,23 +2,112 @@
 
 
 #include "DefaultItem.h"
+#include "FirstRPG.h"
+#include "FirstRPGCharacter.h"
+#include "Internationalization/StringTableRegistry.h"
+#include "Internationalization/StringTableCore.h"
 
 // Sets default values
 ADefaultItem::ADefaultItem()
 {
+	LLM_SCOPE_BYTAG(FirstRPG_Items);
+
  	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = true;
 	weight = 1.0f;
-	name = "Item";
+	itemId = TEXT("Item");
+	displayName = FText::FromStringTable(FirstRPGStringTables::Items, TEXT("Item"));
+}
+
+void ADefaultItem::PostLoad()
+{
+	Super::PostLoad();
+
+	//Items saved before displayName existed kept their old name only, redirected into itemId, and
+	//load with the table's generic "Item". Show the old name instead: through the Items table when
+	//it has a matching key, otherwise as it was written.
+	FName tableId;
+	FString key;
+	if (itemId != TEXT("Item") && FTextInspector::GetTableIdAndKey(displayName, tableId, key)
+		&& tableId == FirstRPGStringTables::Items && key == TEXT("Item"))
+	{
+		const FString oldName = itemId.ToString();
+		FStringTableConstPtr table = FStringTableRegistry::Get().FindStringTable(FirstRPGStringTables::Items);
+		FString sourceString;
+		if (table.IsValid() && table->GetSourceString(FTextKey(oldName), sourceString))
+		{
+			displayName = FText::FromStringTable(FirstRPGStringTables::Items, oldName);
+		}
+		else
+		{
+			displayName = FText::AsCultureInvariant(oldName);
+		}
+	}
 }
 
 // Called when the game starts or when spawned
 void ADefaultItem::BeginPlay()
 {
+	LLM_SCOPE_BYTAG(FirstRPG_Items);
+
 	Super::BeginPlay();
 	
 }
 
+void ADefaultItem::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	//The item may still sit in an inventory and will be nulled by GC; let its holders drop it
+	hasEndedPlay = true;
+	for (const TWeakObjectPtr<AFirstRPGCharacter>& holder : holders)
+	{
+		if (AFirstRPGCharacter* character = holder.Get())
+		{
+			character->OnHeldItemEnded();
+		}
+	}
+	holders.Reset();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ADefaultItem::SetWeight(float _weight)
+{
+	weight = _weight;
+	NotifyHoldersKeysChanged();
+}
+
+void ADefaultItem::SetDisplayName(const FText& _displayName)
+{
+	displayName = _displayName;
+	NotifyHoldersKeysChanged();
+}
+
+void ADefaultItem::AddHolder(AFirstRPGCharacter* _holder)
+{
+	holders.AddUnique(_holder);
+}
+
+void ADefaultItem::RemoveHolder(AFirstRPGCharacter* _holder)
+{
+	holders.RemoveSingleSwap(_holder);
+}
+
+void ADefaultItem::NotifyHoldersKeysChanged()
+{
+	for (const TWeakObjectPtr<AFirstRPGCharacter>& holder : holders)
+	{
+		if (AFirstRPGCharacter* character = holder.Get())
+		{
+			character->OnHeldItemChanged(this);
+		}
+	}
+}
+
+bool ADefaultItem::IsSameItem(const ADefaultItem* _other) const
+{
+	return _other != nullptr && _other->itemId == itemId;
+}
+
 // Called every frame
 void ADefaultItem::Tick(float DeltaTime)
 {
@@ -6,6 +6,8 @@
 #include "GameFramework/Actor.h"
 #include "DefaultItem.generated.h"
 
+class AFirstRPGCharacter;
+
 UCLASS()
 class FIRSTRPG_API ADefaultItem : public AActor
 {
@@ -15,20 +17,54 @@ public:
 	// Sets default values for this actor's properties
 	ADefaultItem();
 
+	virtual void PostLoad() override;
+
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 public:	
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
 
-	//Item weight
-	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	//Item weight. Blueprint writes go through SetWeight so inventories re-sort.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, BlueprintSetter = SetWeight)
 	float weight;
 
-	//Item name
+	//Identifies the kind of item; matching items is a name-index compare, not a string compare
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
-	FString name;
+	FName itemId;
+
+	//Text shown to the player, normally a key into the shared FirstRPG.Items string table
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, BlueprintSetter = SetDisplayName)
+	FText displayName;
+
+	UFUNCTION(BlueprintSetter)
+	void SetWeight(float _weight);
+
+	UFUNCTION(BlueprintSetter)
+	void SetDisplayName(const FText& _displayName);
+
+	//Characters whose inventories hold this item, kept by AFirstRPGCharacter. A change to the item's
+	//name, weight or weapon type re-sorts only its slots in their inventories.
+	void AddHolder(AFirstRPGCharacter* _holder);
+	void RemoveHolder(AFirstRPGCharacter* _holder);
+
+	//True once the item has left play; inventories still holding it drop it on their next query
+	bool HasEndedPlay() const { return hasEndedPlay; }
+
+	//Whether another item is the same kind as this one
+	UFUNCTION(BlueprintCallable, Category = "Item")
+	bool IsSameItem(const ADefaultItem* _other) const;
+
+protected:
+	//Called after a sort key changed
+	void NotifyHoldersKeysChanged();
+
+private:
+	TArray<TWeakObjectPtr<AFirstRPGCharacter>, TInlineAllocator<1>> holders;
+	bool hasEndedPlay = false;
 
 };
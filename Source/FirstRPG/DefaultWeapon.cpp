@@ -2,10 +2,13 @@
 
 
 #include "DefaultWeapon.h"
+#include "FirstRPG.h"
 
 // Sets default values
 ADefaultWeapon::ADefaultWeapon()
 {
+	LLM_SCOPE_BYTAG(FirstRPG_Items);
+
  	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = true;
 
@@ -20,10 +23,18 @@ ADefaultWeapon::ADefaultWeapon()
 // Called when the game starts or when spawned
 void ADefaultWeapon::BeginPlay()
 {
+	LLM_SCOPE_BYTAG(FirstRPG_Items);
+
 	Super::BeginPlay();
 	
 }
 
+void ADefaultWeapon::SetWeaponType(EWeaponType _weaponType)
+{
+	weaponType = _weaponType;
+	NotifyHoldersKeysChanged();
+}
+
 // Called every frame
 void ADefaultWeapon::Tick(float DeltaTime)
 {
@@ -41,10 +41,13 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon")
     float baseSpeed;
 
-    //The type of weapon.
-    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon")
+    //The type of weapon. Blueprint writes go through SetWeaponType so inventories re-sort.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, BlueprintSetter = SetWeaponType, Category = "Weapon")
     EWeaponType weaponType;
 
+    UFUNCTION(BlueprintSetter)
+    void SetWeaponType(EWeaponType _weaponType);
+
 protected:
     //Called when the game starts or when spawned.
     virtual void BeginPlay() override;
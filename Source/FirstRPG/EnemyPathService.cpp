@@ -0,0 +1,373 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "EnemyPathService.h"
+#include "FirstRPG.h"
+#include "MyActor.h"
+#include "AIController.h"
+#include "NavigationData.h"
+#include "NavigationSystem.h"
+#include "NavFilters/NavigationQueryFilter.h"
+#include "HAL/IConsoleManager.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+
+DECLARE_STATS_GROUP(TEXT("FirstRPG Paths"), STATGROUP_FirstRPGPaths, STATCAT_Advanced);
+DECLARE_CYCLE_STAT(TEXT("Path Service Tick"), STAT_EnemyPathServiceTick, STATGROUP_FirstRPGPaths);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Path Requests"), STAT_EnemyPathRequests, STATGROUP_FirstRPGPaths);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Path Queries Issued"), STAT_EnemyPathQueriesIssued, STATGROUP_FirstRPGPaths);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Path Cache Hits"), STAT_EnemyPathCacheHits, STATGROUP_FirstRPGPaths);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Path Queries Shared"), STAT_EnemyPathShared, STATGROUP_FirstRPGPaths);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Path Queries Queued"), STAT_EnemyPathQueued, STATGROUP_FirstRPGPaths);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Paths Cached"), STAT_EnemyPathsCached, STATGROUP_FirstRPGPaths);
+
+CSV_DEFINE_CATEGORY(FirstRPGPaths, true);
+
+static TAutoConsoleVariable<int32> CVarPathMaxQueriesPerFrame(
+	TEXT("FirstRPG.Paths.MaxQueriesPerFrame"),
+	4,
+	TEXT("Navmesh path queries the enemy path service may start per frame. The rest wait for later frames."));
+
+static TAutoConsoleVariable<float> CVarPathShareCellSize(
+	TEXT("FirstRPG.Paths.ShareCellSize"),
+	250.0f,
+	TEXT("Size of the grid cells start and goal points are snapped to. Requests in the same cells share one path."));
+
+static TAutoConsoleVariable<float> CVarPathCacheLifetime(
+	TEXT("FirstRPG.Paths.CacheLifetime"),
+	2.0f,
+	TEXT("Seconds a finished path may be reused before it is queried again."));
+
+bool UEnemyPathService::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UEnemyPathService::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	//The navigation system is created after subsystems initialize, so hook it here
+	if (UNavigationSystemV1* navSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(&InWorld))
+	{
+		navSystem->OnNavigationGenerationFinishedDelegate.AddUniqueDynamic(this, &UEnemyPathService::OnNavigationRebuilt);
+	}
+}
+
+void UEnemyPathService::Deinitialize()
+{
+	if (UNavigationSystemV1* navSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld()))
+	{
+		navSystem->OnNavigationGenerationFinishedDelegate.RemoveDynamic(this, &UEnemyPathService::OnNavigationRebuilt);
+
+		for (const TPair<uint32, FPathKey>& query : runningQueries)
+		{
+			navSystem->AbortAsyncFindPathRequest(query.Key);
+		}
+	}
+
+	runningQueries.Empty();
+	latestRequests.Empty();
+	queuedKeys.Empty();
+	pending.Empty();
+	cache.Empty();
+
+	Super::Deinitialize();
+}
+
+void UEnemyPathService::RequestPath(AMyActor* _enemy, FVector _goal)
+{
+	LLM_SCOPE_BYTAG(FirstRPG_Enemies);
+
+	FPathKey key;
+	if (!MakeKey(_enemy, _goal, key))
+	{
+		return;
+	}
+
+	frameStats.requests++;
+	RequestKeyedPath(_enemy, _goal, key);
+}
+
+void UEnemyPathService::RequestKeyedPath(AMyActor* _enemy, const FVector& _goal, const FPathKey& _key)
+{
+	//Answered now, so any query this enemy is still waiting on is superseded
+	if (const FCachedPath* cached = cache.Find(_key))
+	{
+		frameStats.cacheHits++;
+		latestRequests.Remove(_enemy);
+		const FNavPathSharedPtr path = cached->path;
+		DeliverPath(_enemy, _goal, _key, *path, _key.soleEnemy != nullptr);
+		return;
+	}
+
+	const FPathWaiter waiter = { _enemy, ++nextRequestId, _goal };
+	latestRequests.Add(_enemy, waiter.requestId);
+
+	if (FPendingPath* existing = pending.Find(_key))
+	{
+		//Asking again for the same cells only renews the request; it saves no query of its own
+		if (FPathWaiter* sameEnemy = existing->waiters.FindByPredicate([&waiter](const FPathWaiter& _other) { return _other.enemy == waiter.enemy; }))
+		{
+			sameEnemy->requestId = waiter.requestId;
+			sameEnemy->goal = waiter.goal;
+		}
+		else
+		{
+			frameStats.sharedQueries++;
+			existing->waiters.Add(waiter);
+		}
+		return;
+	}
+
+	FPendingPath& newPending = pending.Add(_key);
+	newPending.start = _enemy->GetActorLocation();
+	newPending.goal = _goal;
+	newPending.agentProperties = _enemy->GetNavAgentPropertiesRef();
+	newPending.querier = _enemy;
+	newPending.waiters.Add(waiter);
+	queuedKeys.Add(_key);
+}
+
+void UEnemyPathService::InvalidateCache()
+{
+	navGeneration++;
+	cache.Empty();
+}
+
+float UEnemyPathService::GetCacheHitRate() const
+{
+	return totalStats.requests > 0 ? (float)(totalStats.cacheHits + totalStats.sharedQueries - totalStats.blockedShares) / totalStats.requests : 0.0f;
+}
+
+void UEnemyPathService::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_EnemyPathServiceTick);
+	TRACE_CPUPROFILER_EVENT_SCOPE(UEnemyPathService::Tick);
+
+	Super::Tick(DeltaTime);
+
+	//Old corridors go stale as the player moves, even if the navmesh has not changed
+	const double now = GetWorld()->GetTimeSeconds();
+	const double lifetime = CVarPathCacheLifetime.GetValueOnGameThread();
+	for (auto iterator = cache.CreateIterator(); iterator; ++iterator)
+	{
+		if (now - iterator.Value().foundTime > lifetime)
+		{
+			iterator.RemoveCurrent();
+		}
+	}
+
+	const int32 budget = FMath::Max(1, CVarPathMaxQueriesPerFrame.GetValueOnGameThread());
+	int32 numStarted = 0;
+	while (numStarted < budget && numStarted < queuedKeys.Num())
+	{
+		const FPathKey& key = queuedKeys[numStarted];
+		if (FPendingPath* pendingPath = pending.Find(key))
+		{
+			StartQuery(key, *pendingPath);
+		}
+		numStarted++;
+	}
+	queuedKeys.RemoveAt(0, numStarted, false);
+
+	SET_DWORD_STAT(STAT_EnemyPathRequests, frameStats.requests);
+	SET_DWORD_STAT(STAT_EnemyPathQueriesIssued, frameStats.queriesIssued);
+	SET_DWORD_STAT(STAT_EnemyPathCacheHits, frameStats.cacheHits);
+	SET_DWORD_STAT(STAT_EnemyPathShared, frameStats.sharedQueries);
+	SET_DWORD_STAT(STAT_EnemyPathQueued, queuedKeys.Num());
+	SET_DWORD_STAT(STAT_EnemyPathsCached, cache.Num());
+
+	CSV_CUSTOM_STAT(FirstRPGPaths, Requests, frameStats.requests, ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(FirstRPGPaths, QueriesIssued, frameStats.queriesIssued, ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(FirstRPGPaths, CacheHits, frameStats.cacheHits + frameStats.sharedQueries - frameStats.blockedShares, ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(FirstRPGPaths, QueriesQueued, queuedKeys.Num(), ECsvCustomStatOp::Set);
+
+	totalStats.requests += frameStats.requests;
+	totalStats.cacheHits += frameStats.cacheHits;
+	totalStats.sharedQueries += frameStats.sharedQueries;
+	totalStats.blockedShares += frameStats.blockedShares;
+	totalStats.queriesIssued += frameStats.queriesIssued;
+	frameStats = FEnemyPathStats();
+}
+
+TStatId UEnemyPathService::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UEnemyPathService, STATGROUP_Tickables);
+}
+
+bool UEnemyPathService::MakeKey(const AMyActor* _enemy, const FVector& _goal, FPathKey& _outKey) const
+{
+	const UNavigationSystemV1* navSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	if (_enemy == nullptr || navSystem == nullptr)
+	{
+		return false;
+	}
+
+	const FVector start = _enemy->GetActorLocation();
+	_outKey.navData = navSystem->GetNavDataForProps(_enemy->GetNavAgentPropertiesRef(), start);
+	if (_outKey.navData == nullptr)
+	{
+		return false;
+	}
+
+	//Points either side of a cell edge will not share, which only costs an extra query
+	const double cellSize = FMath::Max(1.0f, CVarPathShareCellSize.GetValueOnGameThread());
+	auto toCell = [cellSize](const FVector& _point)
+	{
+		return FIntVector(FMath::FloorToInt32(_point.X / cellSize), FMath::FloorToInt32(_point.Y / cellSize), FMath::FloorToInt32(_point.Z / cellSize));
+	};
+	_outKey.startCell = toCell(start);
+	_outKey.goalCell = toCell(_goal);
+	return true;
+}
+
+void UEnemyPathService::StartQuery(const FPathKey& _key, FPendingPath& _pending)
+{
+	UNavigationSystemV1* navSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	if (navSystem == nullptr || _key.navData == nullptr)
+	{
+		AbandonPending(_key);
+		return;
+	}
+
+	const FPathFindingQuery query(_pending.querier.Get(), *_key.navData, _pending.start, _pending.goal,
+		UNavigationQueryFilter::GetQueryFilter(*_key.navData, _pending.querier.Get(), nullptr));
+
+	_pending.queryId = navSystem->FindPathAsync(_pending.agentProperties, query,
+		FNavPathQueryDelegate::CreateUObject(this, &UEnemyPathService::OnPathFound), EPathFindingMode::Regular);
+
+	if (_pending.queryId == INVALID_NAVQUERYID)
+	{
+		AbandonPending(_key);
+		return;
+	}
+
+	_pending.navGeneration = navGeneration;
+	runningQueries.Add(_pending.queryId, _key);
+	frameStats.queriesIssued++;
+}
+
+void UEnemyPathService::OnPathFound(uint32 _queryId, ENavigationQueryResult::Type _result, FNavPathSharedPtr _path)
+{
+	FPathKey key;
+	if (!runningQueries.RemoveAndCopyValue(_queryId, key))
+	{
+		return;
+	}
+
+	FPendingPath* running = pending.Find(key);
+	if (running == nullptr)
+	{
+		return;
+	}
+
+	//Found on a navmesh that has since been rebuilt; queue it again, keeping its waiters, instead of using it
+	if (running->navGeneration != navGeneration)
+	{
+		running->queryId = INVALID_NAVQUERYID;
+		if (const AMyActor* querier = running->querier.Get())
+		{
+			running->start = querier->GetActorLocation();
+		}
+		queuedKeys.Insert(key, 0);
+		return;
+	}
+
+	FPendingPath finished;
+	pending.RemoveAndCopyValue(key, finished);
+
+	//Failed queries are not cached, so the next request tries again
+	const bool succeeded = _result == ENavigationQueryResult::Success && _path.IsValid() && _path->IsValid();
+	if (succeeded)
+	{
+		FCachedPath& cached = cache.Add(key);
+		cached.path = _path;
+		cached.foundTime = GetWorld()->GetTimeSeconds();
+	}
+
+	for (const FPathWaiter& waiter : finished.waiters)
+	{
+		//An enemy that asked again since, for this goal or another, only gets its newest answer
+		if (!ConsumeLatestRequest(waiter) || !succeeded)
+		{
+			continue;
+		}
+		if (AMyActor* enemy = waiter.enemy.Get())
+		{
+			DeliverPath(enemy, waiter.goal, key, *_path, key.soleEnemy != nullptr || waiter.enemy == finished.querier);
+		}
+	}
+}
+
+void UEnemyPathService::AbandonPending(const FPathKey& _key)
+{
+	FPendingPath abandoned;
+	if (pending.RemoveAndCopyValue(_key, abandoned))
+	{
+		for (const FPathWaiter& waiter : abandoned.waiters)
+		{
+			ConsumeLatestRequest(waiter);
+		}
+	}
+}
+
+bool UEnemyPathService::ConsumeLatestRequest(const FPathWaiter& _waiter)
+{
+	const uint32* latest = latestRequests.Find(_waiter.enemy);
+	if (latest == nullptr || *latest != _waiter.requestId)
+	{
+		return false;
+	}
+
+	latestRequests.Remove(_waiter.enemy);
+	return true;
+}
+
+void UEnemyPathService::OnNavigationRebuilt(ANavigationData* _navData)
+{
+	InvalidateCache();
+}
+
+bool UEnemyPathService::DeliverPath(AMyActor* _enemy, const FVector& _goal, const FPathKey& _key, const FNavigationPath& _sharedPath, bool _ownQuery)
+{
+	AAIController* controller = Cast<AAIController>(_enemy->GetController());
+	const TArray<FNavPathPoint>& sharedPoints = _sharedPath.GetPathPoints();
+	if (controller == nullptr || sharedPoints.Num() < 2)
+	{
+		return false;
+	}
+
+	//Someone else's first leg is replaced, so make sure the new one stays on the navmesh. A path queried for this
+	//enemy is used as is, which also keeps a blocked enemy from asking over and over.
+	const ANavigationData* navData = _sharedPath.GetNavigationDataUsed();
+	if (!_ownQuery && navData != nullptr)
+	{
+		FVector hitLocation;
+		if (navData->Raycast(_enemy->GetActorLocation(), sharedPoints[1].Location, hitLocation, UNavigationQueryFilter::GetQueryFilter(*navData, _enemy, nullptr), _enemy))
+		{
+			frameStats.blockedShares++;
+			FPathKey soleKey = _key;
+			soleKey.soleEnemy = _enemy;
+			RequestKeyedPath(_enemy, _goal, soleKey);
+			return false;
+		}
+	}
+
+	//Same corridor, but starting from this enemy rather than whoever the query was made for
+	TArray<FVector> points;
+	points.Reserve(sharedPoints.Num());
+	points.Add(_enemy->GetActorLocation());
+	for (int32 i = 1; i < sharedPoints.Num(); i++)
+	{
+		points.Add(sharedPoints[i].Location);
+	}
+
+	FNavPathSharedPtr enemyPath = MakeShared<FNavigationPath, ESPMode::ThreadSafe>(points, nullptr);
+	enemyPath->SetNavigationDataUsed(_sharedPath.GetNavigationDataUsed());
+
+	FAIMoveRequest moveRequest(points.Last());
+	moveRequest.SetUsePathfinding(true);
+	controller->RequestMove(moveRequest, enemyPath);
+	return true;
+}
@@ -0,0 +1,174 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "NavigationSystemTypes.h"
+#include "EnemyPathService.generated.h"
+
+class AMyActor;
+class ANavigationData;
+
+/**
+ * Path requests for enemies. Requests are queued and run as async navmesh queries, at most a few
+ * per frame. Enemies whose start and goal fall in the same grid cells share one query and one
+ * result, and finished paths are cached until they expire or the navmesh is rebuilt. Each enemy gets
+ * its own copy of the path, starting from where it actually stands, handed to its AI controller. If
+ * the navmesh blocks the way from where it stands to the path's second point, e.g. a wall or ledge
+ * inside the same cell, the enemy gets a query of its own instead.
+ *
+ * Only an enemy's newest request is ever delivered, and a query that was running when the navmesh
+ * was rebuilt is run again rather than handing out a path across the old navmesh.
+ */
+
+//Counters for the current frame and running totals
+USTRUCT(BlueprintType)
+struct FEnemyPathStats
+{
+	GENERATED_BODY()
+
+public:
+	//Requests made by enemies
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	int requests = 0;
+
+	//Requests answered from a finished path in the cache
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	int cacheHits = 0;
+
+	//Requests that joined a query already queued or running for another enemy
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	int sharedQueries = 0;
+
+	//Cache hits and shared results an enemy could not use, because the navmesh blocked the way
+	//from it to the corridor; each of these got a query of its own
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	int blockedShares = 0;
+
+	//Navmesh queries actually started
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	int queriesIssued = 0;
+};
+
+UCLASS()
+class FIRSTRPG_API UEnemyPathService : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	//Asks for a path from the enemy's location to _goal. The enemy's AI controller is told to follow it once ready.
+	UFUNCTION(BlueprintCallable, Category = "Navigation")
+	void RequestPath(AMyActor* _enemy, FVector _goal);
+
+	//Forgets every cached path and re-runs queries already in flight, e.g. after the navmesh changes
+	UFUNCTION(BlueprintCallable, Category = "Navigation")
+	void InvalidateCache();
+
+	UFUNCTION(BlueprintCallable, Category = "Navigation")
+	FEnemyPathStats GetTotalStats() const { return totalStats; }
+
+	//Fraction of all requests that did not need a query of their own
+	UFUNCTION(BlueprintCallable, Category = "Navigation")
+	float GetCacheHitRate() const;
+
+	// UTickableWorldSubsystem interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	//Start and goal snapped to the sharing grid, per navmesh
+	struct FPathKey
+	{
+		FIntVector startCell;
+		FIntVector goalCell;
+		const ANavigationData* navData = nullptr;
+
+		//Set for a query only this enemy may use, after a shared corridor was blocked for it
+		const AMyActor* soleEnemy = nullptr;
+
+		bool operator==(const FPathKey& _other) const
+		{
+			return startCell == _other.startCell && goalCell == _other.goalCell && navData == _other.navData && soleEnemy == _other.soleEnemy;
+		}
+
+		friend uint32 GetTypeHash(const FPathKey& _key)
+		{
+			return HashCombine(HashCombine(HashCombine(GetTypeHash(_key.startCell), GetTypeHash(_key.goalCell)), PointerHash(_key.navData)), PointerHash(_key.soleEnemy));
+		}
+	};
+
+	struct FCachedPath
+	{
+		FNavPathSharedPtr path;
+		double foundTime = 0.0;
+	};
+
+	//An enemy waiting on a query, which of its requests this is, and the goal it asked for
+	struct FPathWaiter
+	{
+		TWeakObjectPtr<AMyActor> enemy;
+		uint32 requestId = 0;
+		FVector goal = FVector::ZeroVector;
+	};
+
+	//A query waiting for budget or running, and everyone who wants its result
+	struct FPendingPath
+	{
+		FVector start;
+		FVector goal;
+		FNavAgentProperties agentProperties;
+		TWeakObjectPtr<AMyActor> querier;
+		TArray<FPathWaiter> waiters;
+		uint32 queryId = INVALID_NAVQUERYID;
+
+		//navGeneration when the query started
+		uint32 navGeneration = 0;
+	};
+
+	bool MakeKey(const AMyActor* _enemy, const FVector& _goal, FPathKey& _outKey) const;
+
+	//Answers from the cache, joins a pending query for the same key, or queues a new one
+	void RequestKeyedPath(AMyActor* _enemy, const FVector& _goal, const FPathKey& _key);
+	void StartQuery(const FPathKey& _key, FPendingPath& _pending);
+	void OnPathFound(uint32 _queryId, ENavigationQueryResult::Type _result, FNavPathSharedPtr _path);
+
+	UFUNCTION()
+	void OnNavigationRebuilt(ANavigationData* _navData);
+
+	//Copies the shared path so it starts at the enemy, and hands it to the enemy's controller. Unless the query
+	//was made for this enemy, first checks the navmesh lets it reach the corridor; if not, requests a path of
+	//its own instead and returns false.
+	bool DeliverPath(AMyActor* _enemy, const FVector& _goal, const FPathKey& _key, const FNavigationPath& _sharedPath, bool _ownQuery);
+
+	//Drops a query that could not start, along with its waiters' requests
+	void AbandonPending(const FPathKey& _key);
+
+	//Whether _waiter still wants this result; forgets the request if so
+	bool ConsumeLatestRequest(const FPathWaiter& _waiter);
+
+	TMap<FPathKey, FCachedPath> cache;
+	TMap<FPathKey, FPendingPath> pending;
+
+	//Keys waiting for budget, oldest first
+	TArray<FPathKey> queuedKeys;
+
+	//Running queries back to their key
+	TMap<uint32, FPathKey> runningQueries;
+
+	//Each enemy's newest request still waiting on a query; older ones are dropped when they finish
+	TMap<TWeakObjectPtr<AMyActor>, uint32> latestRequests;
+	uint32 nextRequestId = 0;
+
+	//Bumped by every navmesh rebuild; results of queries started before it are thrown away
+	uint32 navGeneration = 0;
+
+	FEnemyPathStats frameStats;
+	FEnemyPathStats totalStats;
+};
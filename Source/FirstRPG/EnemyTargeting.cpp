@@ -0,0 +1,197 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "EnemyTargeting.h"
+#include "FirstRPG.h"
+#include "HAL/IConsoleManager.h"
+#include "Math/RandomStream.h"
+#include "Math/VectorRegister.h"
+
+static FAutoConsoleCommand BenchTargetingCommand(
+	TEXT("FirstRPG.BenchTargeting"),
+	TEXT("Times batched SIMD target acquisition against the per-enemy loop. Args: [enemies=1000] [players=8] [iterations=200]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& _args)
+	{
+		const int32 numSeekers = _args.Num() > 0 ? FCString::Atoi(*_args[0]) : 1000;
+		const int32 numTargets = _args.Num() > 1 ? FCString::Atoi(*_args[1]) : 8;
+		const int32 iterations = _args.Num() > 2 ? FCString::Atoi(*_args[2]) : 200;
+		FTargetAcquisitionBatch::RunBenchmark(FMath::Max(1, numSeekers), FMath::Max(1, numTargets), FMath::Max(1, iterations));
+	}));
+
+void FTargetAcquisitionBatch::Reset(int32 _expectedSeekers, int32 _expectedTargets)
+{
+	const int32 paddedSeekers = Align(_expectedSeekers, 4);
+	for (TArray<float>* column : { &seekerX, &seekerY, &seekerZ, &forwardX, &forwardY, &forwardZ, &rangeSquared, &cosHalfAngle })
+	{
+		column->Reset(paddedSeekers);
+	}
+	numSeekers = 0;
+
+	targetX.Reset(_expectedTargets);
+	targetY.Reset(_expectedTargets);
+	targetZ.Reset(_expectedTargets);
+}
+
+void FTargetAcquisitionBatch::AddSeeker(const FVector3f& _position, const FVector3f& _forward, float _range, float _viewHalfAngleDegrees)
+{
+	//Grow by a whole vector at a time; the unused lanes get a negative range so no distance passes
+	if (numSeekers == seekerX.Num())
+	{
+		for (TArray<float>* column : { &seekerX, &seekerY, &seekerZ, &forwardX, &forwardY, &forwardZ, &cosHalfAngle })
+		{
+			column->AddZeroed(4);
+		}
+		rangeSquared.Add(-1.0f);
+		rangeSquared.Add(-1.0f);
+		rangeSquared.Add(-1.0f);
+		rangeSquared.Add(-1.0f);
+	}
+
+	const int32 index = numSeekers++;
+	seekerX[index] = _position.X;
+	seekerY[index] = _position.Y;
+	seekerZ[index] = _position.Z;
+	forwardX[index] = _forward.X;
+	forwardY[index] = _forward.Y;
+	forwardZ[index] = _forward.Z;
+	rangeSquared[index] = FMath::Square(_range);
+	//cos(180) is -1, and a target straight behind would then only pass the cone test if rounding favoured it;
+	//-2 is below any dot(to, forward) / |to|, so an all-round seeker accepts every target in range
+	cosHalfAngle[index] = _viewHalfAngleDegrees >= 180.0f ? -2.0f : FMath::Cos(FMath::DegreesToRadians(FMath::Max(_viewHalfAngleDegrees, 0.0f)));
+}
+
+void FTargetAcquisitionBatch::AddTarget(const FVector3f& _position)
+{
+	targetX.Add(_position.X);
+	targetY.Add(_position.Y);
+	targetZ.Add(_position.Z);
+}
+
+void FTargetAcquisitionBatch::FindBestTargets(TArrayView<int32> _outTargets) const
+{
+	FindBestTargets(_outTargets, 0, NumSeekerBlocks());
+}
+
+void FTargetAcquisitionBatch::FindBestTargets(TArrayView<int32> _outTargets, int32 _firstBlock, int32 _numBlocks) const
+{
+	check(_outTargets.Num() >= numSeekers);
+	check(_firstBlock >= 0 && _firstBlock + _numBlocks <= NumSeekerBlocks());
+
+	const VectorRegister4Float noTarget = VectorSetFloat1(-1.0f);
+
+	const int32 endSeeker = FMath::Min((_firstBlock + _numBlocks) * SeekersPerBlock, numSeekers);
+	for (int32 base = _firstBlock * SeekersPerBlock; base < endSeeker; base += SeekersPerBlock)
+	{
+		const VectorRegister4Float seekX = VectorLoad(&seekerX[base]);
+		const VectorRegister4Float seekY = VectorLoad(&seekerY[base]);
+		const VectorRegister4Float seekZ = VectorLoad(&seekerZ[base]);
+		const VectorRegister4Float fwdX = VectorLoad(&forwardX[base]);
+		const VectorRegister4Float fwdY = VectorLoad(&forwardY[base]);
+		const VectorRegister4Float fwdZ = VectorLoad(&forwardZ[base]);
+		const VectorRegister4Float cosAngle = VectorLoad(&cosHalfAngle[base]);
+
+		//Starting the best distance at the range folds the range test into the nearer-than-best test
+		VectorRegister4Float bestDistanceSquared = VectorLoad(&rangeSquared[base]);
+		VectorRegister4Float bestTarget = noTarget;
+
+		for (int32 targetIndex = 0; targetIndex < targetX.Num(); targetIndex++)
+		{
+			const VectorRegister4Float toX = VectorSubtract(VectorLoadFloat1(&targetX[targetIndex]), seekX);
+			const VectorRegister4Float toY = VectorSubtract(VectorLoadFloat1(&targetY[targetIndex]), seekY);
+			const VectorRegister4Float toZ = VectorSubtract(VectorLoadFloat1(&targetZ[targetIndex]), seekZ);
+
+			const VectorRegister4Float distanceSquared = VectorMultiplyAdd(toX, toX, VectorMultiplyAdd(toY, toY, VectorMultiply(toZ, toZ)));
+			const VectorRegister4Float facing = VectorMultiplyAdd(toX, fwdX, VectorMultiplyAdd(toY, fwdY, VectorMultiply(toZ, fwdZ)));
+
+			//In the cone when the angle to the target is within the half angle: dot(to, forward) >= cos * |to|
+			const VectorRegister4Float inCone = VectorCompareGE(facing, VectorMultiply(cosAngle, VectorSqrt(distanceSquared)));
+			const VectorRegister4Float nearer = VectorCompareLE(distanceSquared, bestDistanceSquared);
+			const VectorRegister4Float better = VectorBitwiseAnd(inCone, nearer);
+
+			bestDistanceSquared = VectorSelect(better, distanceSquared, bestDistanceSquared);
+			bestTarget = VectorSelect(better, VectorSetFloat1((float)targetIndex), bestTarget);
+		}
+
+		alignas(16) float lanes[4];
+		VectorStoreAligned(bestTarget, lanes);
+		const int32 numLanes = FMath::Min(4, numSeekers - base);
+		for (int32 lane = 0; lane < numLanes; lane++)
+		{
+			_outTargets[base + lane] = (int32)lanes[lane];
+		}
+	}
+}
+
+void FTargetAcquisitionBatch::FindBestTargetsScalar(TArrayView<int32> _outTargets) const
+{
+	check(_outTargets.Num() >= numSeekers);
+
+	for (int32 seeker = 0; seeker < numSeekers; seeker++)
+	{
+		const FVector3f position(seekerX[seeker], seekerY[seeker], seekerZ[seeker]);
+		const FVector3f forward(forwardX[seeker], forwardY[seeker], forwardZ[seeker]);
+		float bestDistanceSquared = rangeSquared[seeker];
+		_outTargets[seeker] = INDEX_NONE;
+
+		for (int32 targetIndex = 0; targetIndex < targetX.Num(); targetIndex++)
+		{
+			const FVector3f toTarget = FVector3f(targetX[targetIndex], targetY[targetIndex], targetZ[targetIndex]) - position;
+			const float distanceSquared = toTarget.SizeSquared();
+			if (distanceSquared <= bestDistanceSquared && FVector3f::DotProduct(toTarget, forward) >= cosHalfAngle[seeker] * FMath::Sqrt(distanceSquared))
+			{
+				bestDistanceSquared = distanceSquared;
+				_outTargets[seeker] = targetIndex;
+			}
+		}
+	}
+}
+
+void FTargetAcquisitionBatch::RunBenchmark(int32 _numSeekers, int32 _numTargets, int32 _iterations)
+{
+	FRandomStream random(1234);
+	const float worldSize = 20000.0f;
+
+	FTargetAcquisitionBatch batch;
+	batch.Reset(_numSeekers, _numTargets);
+	for (int32 i = 0; i < _numSeekers; i++)
+	{
+		const FVector3f position(random.FRandRange(0.0f, worldSize), random.FRandRange(0.0f, worldSize), random.FRandRange(0.0f, 500.0f));
+		const FVector3f forward = FVector3f(random.GetUnitVector()).GetSafeNormal2D();
+		batch.AddSeeker(position, forward, 3000.0f, 60.0f);
+	}
+	for (int32 i = 0; i < _numTargets; i++)
+	{
+		batch.AddTarget(FVector3f(random.FRandRange(0.0f, worldSize), random.FRandRange(0.0f, worldSize), random.FRandRange(0.0f, 500.0f)));
+	}
+
+	TArray<int32> scalarTargets;
+	TArray<int32> simdTargets;
+	scalarTargets.SetNumUninitialized(_numSeekers);
+	simdTargets.SetNumUninitialized(_numSeekers);
+
+	double startTime = FPlatformTime::Seconds();
+	for (int32 i = 0; i < _iterations; i++)
+	{
+		batch.FindBestTargetsScalar(scalarTargets);
+	}
+	const double scalarUs = (FPlatformTime::Seconds() - startTime) * 1000000.0 / _iterations;
+
+	startTime = FPlatformTime::Seconds();
+	for (int32 i = 0; i < _iterations; i++)
+	{
+		batch.FindBestTargets(simdTargets);
+	}
+	const double simdUs = (FPlatformTime::Seconds() - startTime) * 1000000.0 / _iterations;
+
+	//Both versions pick the nearest target in range, so they should agree apart from exact distance ties
+	int32 numMismatches = 0;
+	int32 numWithTarget = 0;
+	for (int32 i = 0; i < _numSeekers; i++)
+	{
+		numMismatches += scalarTargets[i] != simdTargets[i] ? 1 : 0;
+		numWithTarget += simdTargets[i] != INDEX_NONE ? 1 : 0;
+	}
+
+	UE_LOG(LogFirstRPG, Display, TEXT("Target acquisition, %d enemies x %d players over %d runs: per-enemy %.1f us, batched SIMD %.1f us (%.2fx). %d enemies found a target, %d mismatches."),
+		_numSeekers, _numTargets, _iterations, scalarUs, simdUs, simdUs > 0.0 ? scalarUs / simdUs : 0.0, numWithTarget, numMismatches);
+}
@@ -0,0 +1,57 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Batched target acquisition. Seekers (enemies) and targets (players) are packed one coordinate per
+ * array, so the kernel loads four seekers into a vector register and tests them against each target
+ * in turn: distance against the seeker's range, then the seeker's view cone. One call returns the
+ * nearest visible target for every seeker, or for one range of blocks so workers can split the seekers.
+ */
+struct FIRSTRPG_API FTargetAcquisitionBatch
+{
+	void Reset(int32 _expectedSeekers = 0, int32 _expectedTargets = 0);
+
+	//_forward must be normalized. A half angle of 180 sees all the way round.
+	void AddSeeker(const FVector3f& _position, const FVector3f& _forward, float _range, float _viewHalfAngleDegrees);
+	void AddTarget(const FVector3f& _position);
+
+	int32 NumSeekers() const { return numSeekers; }
+	int32 NumTargets() const { return targetX.Num(); }
+
+	//Seekers go through the kernel four at a time, one vector register's worth
+	static constexpr int32 SeekersPerBlock = 4;
+	int32 NumSeekerBlocks() const { return (numSeekers + SeekersPerBlock - 1) / SeekersPerBlock; }
+
+	//Writes the index of each seeker's best target, or INDEX_NONE, into _outTargets (at least NumSeekers() long)
+	void FindBestTargets(TArrayView<int32> _outTargets) const;
+
+	//The same for seekers in blocks [_firstBlock, _firstBlock + _numBlocks) only. Each call reads and
+	//writes whole blocks of its own, so disjoint ranges can run on different threads at once.
+	void FindBestTargets(TArrayView<int32> _outTargets, int32 _firstBlock, int32 _numBlocks) const;
+
+	//One seeker at a time, the way each enemy used to do it; kept as the reference for the benchmark
+	void FindBestTargetsScalar(TArrayView<int32> _outTargets) const;
+
+	//Times both versions on random data and logs the results; backs the FirstRPG.BenchTargeting command
+	static void RunBenchmark(int32 _numSeekers, int32 _numTargets, int32 _iterations);
+
+private:
+	//Seeker arrays are padded to a multiple of four with seekers that can never see anything
+	TArray<float> seekerX;
+	TArray<float> seekerY;
+	TArray<float> seekerZ;
+	TArray<float> forwardX;
+	TArray<float> forwardY;
+	TArray<float> forwardZ;
+	TArray<float> rangeSquared;
+	//-2 for seekers that see all the way round, which every target passes whatever the rounding
+	TArray<float> cosHalfAngle;
+	int32 numSeekers = 0;
+
+	TArray<float> targetX;
+	TArray<float> targetY;
+	TArray<float> targetZ;
+};
@@ -0,0 +1,95 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "EnemyTargeting.h"
+#include "Math/RandomStream.h"
+
+//Runs the SIMD kernel, whole and split into block ranges, and the scalar reference, and checks all three agree
+static void TestMatchesScalar(FAutomationTestBase& _test, const TCHAR* _what, const FTargetAcquisitionBatch& _batch)
+{
+	TArray<int32> simdTargets;
+	TArray<int32> splitTargets;
+	TArray<int32> scalarTargets;
+	simdTargets.Init(-2, _batch.NumSeekers());
+	splitTargets.Init(-2, _batch.NumSeekers());
+	scalarTargets.Init(-2, _batch.NumSeekers());
+
+	_batch.FindBestTargets(simdTargets);
+	_batch.FindBestTargetsScalar(scalarTargets);
+
+	//Uneven ranges, the way ParallelFor hands out blocks
+	const int32 numBlocks = _batch.NumSeekerBlocks();
+	for (int32 first = 0; first < numBlocks; first += 3)
+	{
+		_batch.FindBestTargets(splitTargets, first, FMath::Min(3, numBlocks - first));
+	}
+
+	for (int32 i = 0; i < _batch.NumSeekers(); i++)
+	{
+		if (!_test.TestEqual(FString::Printf(TEXT("%s: seeker %d SIMD matches scalar"), _what, i), simdTargets[i], scalarTargets[i])
+			|| !_test.TestEqual(FString::Printf(TEXT("%s: seeker %d block ranges match scalar"), _what, i), splitTargets[i], scalarTargets[i]))
+		{
+			return;
+		}
+	}
+}
+
+//The batched target search against the one-seeker-at-a-time reference, including the 180 degree view cone
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEnemyTargetingTest, "FirstRPG.Enemies.Targeting",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ProductFilter)
+
+bool FEnemyTargetingTest::RunTest(const FString& Parameters)
+{
+	FRandomStream random(1234);
+	const float worldSize = 5000.0f;
+	const float halfAngles[] = { 0.0f, 45.0f, 90.0f, 135.0f, 180.0f };
+
+	//A seeker count that leaves a partly filled last block
+	FTargetAcquisitionBatch batch;
+	batch.Reset(1003, 8);
+	for (int32 i = 0; i < 1003; i++)
+	{
+		const FVector3f position(random.FRandRange(0.0f, worldSize), random.FRandRange(0.0f, worldSize), random.FRandRange(0.0f, 500.0f));
+		const FVector3f forward = FVector3f(random.GetUnitVector()).GetSafeNormal2D();
+		batch.AddSeeker(position, forward, random.FRandRange(500.0f, 3000.0f), halfAngles[i % UE_ARRAY_COUNT(halfAngles)]);
+	}
+	for (int32 i = 0; i < 8; i++)
+	{
+		batch.AddTarget(FVector3f(random.FRandRange(0.0f, worldSize), random.FRandRange(0.0f, worldSize), random.FRandRange(0.0f, 500.0f)));
+	}
+	TestMatchesScalar(*this, TEXT("Random"), batch);
+
+	//No players: nobody finds a target
+	FTargetAcquisitionBatch noTargets;
+	for (int32 i = 0; i < 6; i++)
+	{
+		noTargets.AddSeeker(FVector3f((float)i * 100.0f, 0.0f, 0.0f), FVector3f(1.0f, 0.0f, 0.0f), 1000.0f, 180.0f);
+	}
+	TestMatchesScalar(*this, TEXT("No targets"), noTargets);
+	TArray<int32> found;
+	found.Init(0, noTargets.NumSeekers());
+	noTargets.FindBestTargets(found);
+	for (int32 target : found)
+	{
+		TestEqual(TEXT("No targets: seeker finds nothing"), target, (int32)INDEX_NONE);
+	}
+
+	//A target straight behind: seen with a 180 degree half angle, not with 90
+	FTargetAcquisitionBatch behind;
+	behind.AddSeeker(FVector3f::ZeroVector, FVector3f(1.0f, 0.0f, 0.0f), 1000.0f, 180.0f);
+	behind.AddSeeker(FVector3f::ZeroVector, FVector3f(1.0f, 0.0f, 0.0f), 1000.0f, 90.0f);
+	behind.AddTarget(FVector3f(-300.0f, 0.0f, 0.0f));
+	TestMatchesScalar(*this, TEXT("Target behind"), behind);
+	found.Init(-2, behind.NumSeekers());
+	behind.FindBestTargets(found);
+	TestEqual(TEXT("180 degree seeker sees a target directly behind"), found[0], 0);
+	TestEqual(TEXT("90 degree seeker does not see a target directly behind"), found[1], (int32)INDEX_NONE);
+
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,277 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "EnemyUpdateSubsystem.h"
+#include "FirstRPG.h"
+#include "MyActor.h"
+#include "FirstRPGCharacter.h"
+#include "GameplayTelemetry.h"
+#include "Async/ParallelFor.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+
+DECLARE_STATS_GROUP(TEXT("FirstRPG Enemies"), STATGROUP_FirstRPGEnemies, STATCAT_Advanced);
+DECLARE_CYCLE_STAT(TEXT("Enemy Gather"), STAT_EnemyGather, STATGROUP_FirstRPGEnemies);
+DECLARE_CYCLE_STAT(TEXT("Enemy Process"), STAT_EnemyProcess, STATGROUP_FirstRPGEnemies);
+DECLARE_CYCLE_STAT(TEXT("Enemy Write Back"), STAT_EnemyWriteBack, STATGROUP_FirstRPGEnemies);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Enemies Updated"), STAT_EnemiesUpdated, STATGROUP_FirstRPGEnemies);
+
+CSV_DEFINE_CATEGORY(FirstRPGEnemies, true);
+
+static TAutoConsoleVariable<bool> CVarEnemyParallelUpdate(
+	TEXT("FirstRPG.Enemies.ParallelUpdate"),
+	true,
+	TEXT("Process the enemy batch across worker threads. Off runs the same code on the game thread only, for comparison."));
+
+static TAutoConsoleVariable<int32> CVarEnemyMinBatchSize(
+	TEXT("FirstRPG.Enemies.MinBatchSize"),
+	256,
+	TEXT("Fewest enemies handed to one worker, rounded up to whole blocks of four. Below two batches' worth the phase stays on the game thread, since waking and joining workers costs more than the work."));
+
+void FEnemyUpdateTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (subsystem != nullptr && TickType != LEVELTICK_ViewportsOnly)
+	{
+		subsystem->UpdateEnemies(DeltaTime);
+	}
+}
+
+FString FEnemyUpdateTickFunction::DiagnosticMessage()
+{
+	return TEXT("UEnemyUpdateSubsystem::UpdateEnemies");
+}
+
+FName FEnemyUpdateTickFunction::DiagnosticContext(bool bDetailed)
+{
+	return FName(TEXT("EnemyUpdate"));
+}
+
+void FEnemyUpdateBatch::Reset(int32 _numEnemies)
+{
+	enemies.Reset(_numEnemies);
+	health.Reset(_numEnemies);
+	pendingDamage.Reset(_numEnemies);
+	isDead.Reset(_numEnemies);
+	targeting.Reset(_numEnemies);
+	players.Reset();
+
+	newHealth.SetNumUninitialized(_numEnemies, false);
+	results.SetNumUninitialized(_numEnemies, false);
+	targetIndices.SetNumUninitialized(_numEnemies, false);
+}
+
+bool UEnemyUpdateSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UEnemyUpdateSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	//Before physics, so enemies react to last frame's hits before they move this frame
+	updateTick.subsystem = this;
+	updateTick.bCanEverTick = true;
+	updateTick.bStartWithTickEnabled = true;
+	updateTick.TickGroup = TG_PrePhysics;
+	updateTick.RegisterTickFunction(InWorld.PersistentLevel);
+}
+
+void UEnemyUpdateSubsystem::Deinitialize()
+{
+	if (updateTick.IsTickFunctionRegistered())
+	{
+		updateTick.UnRegisterTickFunction();
+	}
+	updateTick.subsystem = nullptr;
+	for (AMyActor* enemy : enemies)
+	{
+		if (enemy != nullptr)
+		{
+			enemy->isUpdateRegistered = false;
+		}
+	}
+	enemies.Empty();
+
+	Super::Deinitialize();
+}
+
+void UEnemyUpdateSubsystem::RegisterEnemy(AMyActor* _enemy)
+{
+	check(IsInGameThread());
+
+	if (_enemy == nullptr || _enemy->isUpdateRegistered)
+	{
+		return;
+	}
+
+	enemies.Add(_enemy);
+	_enemy->isUpdateRegistered = true;
+	_enemy->PrimaryActorTick.AddPrerequisite(this, updateTick);
+}
+
+void UEnemyUpdateSubsystem::UnregisterEnemy(AMyActor* _enemy)
+{
+	check(IsInGameThread());
+
+	if (enemies.RemoveSwap(_enemy) > 0)
+	{
+		_enemy->isUpdateRegistered = false;
+		_enemy->PrimaryActorTick.RemovePrerequisite(this, updateTick);
+	}
+}
+
+bool UEnemyUpdateSubsystem::IsRegistered(const AMyActor* _enemy)
+{
+	return _enemy != nullptr && _enemy->isUpdateRegistered;
+}
+
+void UEnemyUpdateSubsystem::UpdateEnemies(float _deltaTime)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UEnemyUpdateSubsystem::UpdateEnemies);
+	LLM_SCOPE_BYTAG(FirstRPG_Enemies);
+
+	if (enemies.Num() == 0)
+	{
+		return;
+	}
+
+	const double updateStart = FPlatformTime::Seconds();
+
+	GatherBatch();
+	ProcessBatch();
+	WriteBackBatch();
+
+	const float updateMs = (float)((FPlatformTime::Seconds() - updateStart) * 1000.0);
+	SET_DWORD_STAT(STAT_EnemiesUpdated, batch.enemies.Num());
+	CSV_CUSTOM_STAT(FirstRPGEnemies, EnemyCount, batch.enemies.Num(), ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(FirstRPGEnemies, UpdateMs, updateMs, ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(FirstRPGEnemies, GameThreadUsPerEnemy, updateMs * 1000.0f / batch.enemies.Num(), ECsvCustomStatOp::Set);
+}
+
+void UEnemyUpdateSubsystem::GatherBatch()
+{
+	SCOPE_CYCLE_COUNTER(STAT_EnemyGather);
+
+	batch.Reset(enemies.Num());
+
+	for (AMyActor* enemy : enemies)
+	{
+		batch.enemies.Add(enemy);
+		batch.health.Add(enemy->health);
+		batch.pendingDamage.Add(enemy->pendingDamage);
+		batch.isDead.Add(enemy->isDead);
+		batch.targeting.AddSeeker(FVector3f(enemy->GetActorLocation()), FVector3f(enemy->GetActorForwardVector()), enemy->aggroRange, enemy->viewHalfAngle);
+	}
+
+	for (FConstPlayerControllerIterator iterator = GetWorld()->GetPlayerControllerIterator(); iterator; ++iterator)
+	{
+		const APlayerController* controller = iterator->Get();
+		if (AFirstRPGCharacter* player = controller != nullptr ? Cast<AFirstRPGCharacter>(controller->GetPawn()) : nullptr)
+		{
+			batch.players.Add(player);
+			batch.targeting.AddTarget(FVector3f(player->GetActorLocation()));
+		}
+	}
+}
+
+void UEnemyUpdateSubsystem::ProcessBatch()
+{
+	SCOPE_CYCLE_COUNTER(STAT_EnemyProcess);
+
+	//Work is split on whole blocks of four, so no two workers ever share a targeting vector
+	const int32 numBlocks = batch.targeting.NumSeekerBlocks();
+	const int32 minBatchBlocks = FMath::DivideAndRoundUp(FMath::Max(1, CVarEnemyMinBatchSize.GetValueOnGameThread()), FTargetAcquisitionBatch::SeekersPerBlock);
+	const bool runParallel = CVarEnemyParallelUpdate.GetValueOnGameThread() && numBlocks >= minBatchBlocks * 2;
+	const EParallelForFlags flags = runParallel ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread;
+
+	//The game thread joins in and blocks until every worker is done, so nothing else touches the actors meanwhile
+	FEnemyUpdateBatch& enemyBatch = batch;
+	ParallelFor(TEXT("EnemyUpdate"), numBlocks, minBatchBlocks, [&enemyBatch](int32 _block)
+	{
+		ProcessBlock(enemyBatch, _block);
+	}, flags);
+}
+
+void UEnemyUpdateSubsystem::ProcessBlock(FEnemyUpdateBatch& _batch, int32 _block)
+{
+	//These four enemies against every player in one vectorized pass
+	_batch.targeting.FindBestTargets(_batch.targetIndices, _block, 1);
+
+	const int32 first = _block * FTargetAcquisitionBatch::SeekersPerBlock;
+	const int32 last = FMath::Min(first + FTargetAcquisitionBatch::SeekersPerBlock, _batch.enemies.Num());
+	for (int32 index = first; index < last; index++)
+	{
+		ProcessEnemy(_batch, index);
+	}
+}
+
+void UEnemyUpdateSubsystem::ProcessEnemy(FEnemyUpdateBatch& _batch, int32 _index)
+{
+	_batch.newHealth[_index] = _batch.health[_index];
+	_batch.results[_index] = EEnemyUpdateResult::None;
+
+	//The dead do not chase anyone
+	if (_batch.isDead[_index])
+	{
+		_batch.targetIndices[_index] = INDEX_NONE;
+		return;
+	}
+
+	const float damage = _batch.pendingDamage[_index];
+	if (damage > 0.0f)
+	{
+		_batch.newHealth[_index] -= damage;
+		_batch.results[_index] = _batch.newHealth[_index] <= 0.0f ? EEnemyUpdateResult::Died : EEnemyUpdateResult::Damaged;
+
+		//Each hit was recorded by AMyActor::TakeDamage; the death is recorded here, straight from the worker.
+		//The enemy's id and class never change while it is registered.
+		if (_batch.results[_index] == EEnemyUpdateResult::Died)
+		{
+			const AMyActor* enemy = _batch.enemies[_index];
+			FGameplayTelemetry::Record(ETelemetryEvent::Kill, enemy, enemy->GetClass()->GetFName());
+			_batch.targetIndices[_index] = INDEX_NONE;
+		}
+	}
+}
+
+void UEnemyUpdateSubsystem::WriteBackBatch()
+{
+	SCOPE_CYCLE_COUNTER(STAT_EnemyWriteBack);
+
+	TArray<TWeakObjectPtr<AMyActor>, TInlineAllocator<16>> died;
+
+	for (int32 i = 0; i < batch.enemies.Num(); i++)
+	{
+		AMyActor* enemy = batch.enemies[i];
+		enemy->health = batch.newHealth[i];
+		enemy->pendingDamage = 0.0f;
+
+		if (EnumHasAnyFlags(batch.results[i], EEnemyUpdateResult::Damaged))
+		{
+			enemy->hasTakenDamage = true;
+		}
+		if (EnumHasAnyFlags(batch.results[i], EEnemyUpdateResult::Died))
+		{
+			enemy->isDead = true;
+			died.Add(enemy);
+		}
+
+		enemy->target = batch.targetIndices[i] != INDEX_NONE ? batch.players[batch.targetIndices[i]] : nullptr;
+	}
+
+	//Blueprint death handling may destroy actors and unregister them, so it runs after every enemy is written.
+	//One enemy's OnDeath may also destroy another one further down this list.
+	for (const TWeakObjectPtr<AMyActor>& weakEnemy : died)
+	{
+		AMyActor* enemy = weakEnemy.Get();
+		if (IsValid(enemy) && !enemy->IsActorBeingDestroyed())
+		{
+			enemy->OnDeath();
+		}
+	}
+}
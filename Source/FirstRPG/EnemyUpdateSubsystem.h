@@ -0,0 +1,121 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "EnemyTargeting.h"
+#include "EnemyUpdateSubsystem.generated.h"
+
+class AMyActor;
+class AFirstRPGCharacter;
+class UEnemyUpdateSubsystem;
+
+/**
+ * Runs the per-enemy logic (damage reactions, death transitions, target checks) for every AMyActor
+ * in one phase early in the frame. Enemy data is gathered into packed arrays, processed across worker
+ * threads with ParallelFor, then written back to the actors by the game thread alone. Each enemy's
+ * own tick has this phase as a prerequisite, so Blueprint Tick always sees this frame's results.
+ */
+
+//Tick function that drives the update phase
+USTRUCT()
+struct FEnemyUpdateTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+public:
+	UEnemyUpdateSubsystem* subsystem = nullptr;
+
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+	virtual FName DiagnosticContext(bool bDetailed) override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FEnemyUpdateTickFunction> : public TStructOpsTypeTraitsBase2<FEnemyUpdateTickFunction>
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
+
+//Per-enemy outcome flags written by the workers
+enum class EEnemyUpdateResult : uint8
+{
+	None		= 0,
+	Damaged		= 1 << 0,
+	Died		= 1 << 1
+};
+ENUM_CLASS_FLAGS(EEnemyUpdateResult);
+
+//One frame's enemies, one packed array per field; index i is the same enemy in every array
+struct FEnemyUpdateBatch
+{
+	void Reset(int32 _numEnemies);
+
+	//Inputs, filled on the game thread
+	TArray<AMyActor*> enemies;
+	TArray<float> health;
+	TArray<float> pendingDamage;
+	TArray<bool> isDead;
+
+	//Enemy positions and view cones against the players' positions, in the same enemy order
+	FTargetAcquisitionBatch targeting;
+	TArray<AFirstRPGCharacter*> players;
+
+	//Outputs, each index written by exactly one worker
+	TArray<float> newHealth;
+	TArray<EEnemyUpdateResult> results;
+
+	//Index into players, filled by the workers one block of four enemies at a time
+	TArray<int32> targetIndices;
+};
+
+UCLASS()
+class FIRSTRPG_API UEnemyUpdateSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// UWorldSubsystem interface
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	//Enemies join in BeginPlay and leave in EndPlay; joining makes their tick wait for the phase
+	void RegisterEnemy(AMyActor* _enemy);
+	void UnregisterEnemy(AMyActor* _enemy);
+
+	//Whether the enemy is between RegisterEnemy and UnregisterEnemy, i.e. the next phase will update it
+	static bool IsRegistered(const AMyActor* _enemy);
+
+	//Gathers, processes and writes back every registered enemy
+	void UpdateEnemies(float _deltaTime);
+
+	UFUNCTION(BlueprintCallable, Category = "Enemies")
+	int GetNumEnemies() const { return enemies.Num(); }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	void GatherBatch();
+	void ProcessBatch();
+	void WriteBackBatch();
+
+	//Targeting then damage for one block of four enemies. Pure data, safe on any thread; touches only that block's outputs.
+	static void ProcessBlock(FEnemyUpdateBatch& _batch, int32 _block);
+
+	//Runs after the enemy's block has been through targeting; touches only index _index of the outputs
+	static void ProcessEnemy(FEnemyUpdateBatch& _batch, int32 _index);
+
+	UPROPERTY()
+	TArray<AMyActor*> enemies;
+
+	FEnemyUpdateTickFunction updateTick;
+
+	//Kept between frames so the arrays stay allocated
+	FEnemyUpdateBatch batch;
+};
@@ -1,7 +1,58 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "FirstRPG.h"
+#include "GameplayTelemetry.h"
+#include "FirstRPGCharacter.h"
 #include "Modules/ModuleManager.h"
+#include "UObject/UObjectIterator.h"
+#include "Internationalization/Internationalization.h"
+#include "Internationalization/StringTableRegistry.h"
 
-IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, FirstRPG, "FirstRPG" );
- 
\ No newline at end of file
+DEFINE_LOG_CATEGORY(LogFirstRPG);
+
+LLM_DEFINE_TAG(FirstRPG_Characters);
+LLM_DEFINE_TAG(FirstRPG_Enemies);
+LLM_DEFINE_TAG(FirstRPG_Items);
+LLM_DEFINE_TAG(FirstRPG_Inventory);
+LLM_DEFINE_TAG(FirstRPG_Quests);
+
+class FFirstRPGModule : public FDefaultGameModuleImpl
+{
+public:
+	virtual void StartupModule() override
+	{
+		//Every item and quest refers into these tables instead of owning its own display strings.
+		//The macro needs literals, so the IDs here must match FirstRPGStringTables.
+		LOCTABLE_FROMFILE_GAME("FirstRPG.Items", "FirstRPG.Items", "StringTables/Items.csv");
+		LOCTABLE_FROMFILE_GAME("FirstRPG.Quests", "FirstRPG.Quests", "StringTables/Quests.csv");
+
+		//Inventories sort by display name, whose order depends on the culture
+		cultureChangedHandle = FInternationalization::Get().OnCultureChanged().AddStatic(&FFirstRPGModule::ResortInventories);
+
+		FGameplayTelemetry::StartupModule();
+	}
+
+	virtual void ShutdownModule() override
+	{
+		FGameplayTelemetry::ShutdownModule();
+
+		if (FInternationalization::IsAvailable())
+		{
+			FInternationalization::Get().OnCultureChanged().Remove(cultureChangedHandle);
+		}
+	}
+
+private:
+	//Every display name may have changed, so this is the one case that re-sorts every inventory
+	static void ResortInventories()
+	{
+		for (TObjectIterator<AFirstRPGCharacter> it; it; ++it)
+		{
+			it->GetInventory().RebuildIndices();
+		}
+	}
+
+	FDelegateHandle cultureChangedHandle;
+};
+
+IMPLEMENT_PRIMARY_GAME_MODULE( FFirstRPGModule, FirstRPG, "FirstRPG" );
@@ -3,3 +3,23 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "HAL/LowLevelMemTracker.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogFirstRPG, Log, All);
+
+//Object channel for pickups and hazards (see DefaultEngine.ini). Everything ignores it except the player's capsule.
+#define ECC_Pickup ECC_GameTraceChannel1
+
+//Shared string tables for item and quest display text, loaded from Content/StringTables at startup
+namespace FirstRPGStringTables
+{
+	static const TCHAR* const Items = TEXT("FirstRPG.Items");
+	static const TCHAR* const Quests = TEXT("FirstRPG.Quests");
+}
+
+//Low-Level Memory Tracker tags for the game's own subsystems, see UFirstRPGMemoryReport
+LLM_DECLARE_TAG_API(FirstRPG_Characters, FIRSTRPG_API);
+LLM_DECLARE_TAG_API(FirstRPG_Enemies, FIRSTRPG_API);
+LLM_DECLARE_TAG_API(FirstRPG_Items, FIRSTRPG_API);
+LLM_DECLARE_TAG_API(FirstRPG_Inventory, FIRSTRPG_API);
+LLM_DECLARE_TAG_API(FirstRPG_Quests, FIRSTRPG_API);
@@ -1,6 +1,9 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "FirstRPGCharacter.h"
+#include "FirstRPG.h"
+#include "GameplayTelemetry.h"
+#include "GameplayScheduler.h"
 #include "Engine/LocalPlayer.h"
 #include "Camera/CameraComponent.h"
 #include "Components/CapsuleComponent.h"
@@ -18,6 +21,8 @@ DEFINE_LOG_CATEGORY(LogTemplateCharacter);
 
 AFirstRPGCharacter::AFirstRPGCharacter()
 {
+	LLM_SCOPE_BYTAG(FirstRPG_Characters);
+
 	// Set size for collision capsule
 	GetCapsuleComponent()->InitCapsuleSize(42.f, 96.0f);
 		
@@ -77,13 +82,45 @@ AFirstRPGCharacter::AFirstRPGCharacter()
 	experienceToLevel = 2000.0f;
 
 	attackSpeed = 1.0f;
+
+	currentWeapon = nullptr;
+	damageFormula = nullptr;
 }
 
 void AFirstRPGCharacter::BeginPlay()
 {
+	LLM_SCOPE_BYTAG(FirstRPG_Characters);
+
 	// Call the base class  
 	Super::BeginPlay();
 
+	//Items set on the Blueprint defaults need indexing, and need to know who holds them. Sorting a large default inventory is deferred
+	//off the spawn frame; a query before the job runs builds the indices itself.
+	if (UGameplayScheduler* scheduler = GetWorld()->GetSubsystem<UGameplayScheduler>())
+	{
+		scheduler->Schedule(TEXT("InventoryIndex"), EGameplayJobPriority::E_High, [weakThis = TWeakObjectPtr<AFirstRPGCharacter>(this)]()
+		{
+			if (AFirstRPGCharacter* character = weakThis.Get())
+			{
+				character->inventory.EnsureIndices();
+			}
+		});
+	}
+	else
+	{
+		inventory.RebuildIndices();
+	}
+	for (ADefaultItem* item : inventory.itemList)
+	{
+		if (item != nullptr)
+		{
+			item->AddHolder(this);
+		}
+	}
+
+	//Only the player overlaps pickups and hazards; set here so the capsule's collision profile cannot overwrite it on load
+	GetCapsuleComponent()->SetCollisionResponseToChannel(ECC_Pickup, ECR_Overlap);
+
 	//Add Input Mapping Context
 	if (APlayerController* PlayerController = Cast<APlayerController>(Controller))
 	{
@@ -229,7 +266,8 @@ void AFirstRPGCharacter::TakeDamage(float _damageAmount)
 			playerHealth = 0.00f;
 		}
 	}
-	
+
+	FGameplayTelemetry::Record(ETelemetryEvent::Damage, this, NAME_None, _damageAmount, playerHealth);
 }
 
 void AFirstRPGCharacter::Heal(float _healAmount)
@@ -313,6 +351,8 @@ void AFirstRPGCharacter::GainExperience(float _expAmount)
 		experiencePoints -= experienceToLevel;
 		experienceToLevel += 500.0f;
 		currentLevel++;
+
+		FGameplayTelemetry::Record(ETelemetryEvent::LevelUp, this, NAME_None, (float)currentLevel);
 	}
 }
 
@@ -321,7 +361,75 @@ void AFirstRPGCharacter::Punch()
 	hasPunched = true;
 }
 
+FDamageHitInput AFirstRPGCharacter::MakeHitInput() const
+{
+	FDamageHitInput hit;
+	hit.strength = strengthValue;
+	hit.dexterity = dexterityValue;
+	hit.attackSpeed = attackSpeed;
+	hit.level = currentLevel;
+
+	if (currentWeapon != nullptr)
+	{
+		hit.baseDamage = currentWeapon->baseDamage;
+		hit.baseSpeed = currentWeapon->baseSpeed;
+		hit.levelReq = currentWeapon->levelReq;
+		hit.weaponType = currentWeapon->weaponType;
+	}
+
+	return hit;
+}
+
+float AFirstRPGCharacter::ComputeHitDamage() const
+{
+	const FDamageHitInput hit = MakeHitInput();
+	return damageFormula != nullptr ? damageFormula->EvaluateHit(hit) : hit.baseDamage;
+}
+
 void AFirstRPGCharacter::AddToInventory(ADefaultItem* _item)
 {
-	inventory.itemList.Add(_item);
+	inventory.AddItem(_item);
+
+	if (_item != nullptr)
+	{
+		_item->AddHolder(this);
+		FGameplayTelemetry::Record(ETelemetryEvent::Pickup, this, _item->itemId, 1.0f);
+	}
+}
+
+void AFirstRPGCharacter::AddLootToInventory(const TArray<FLootDrop>& _drops)
+{
+	for (const FLootDrop& drop : _drops)
+	{
+		inventory.AddStack(drop);
+
+		if (drop.item != nullptr)
+		{
+			FGameplayTelemetry::Record(ETelemetryEvent::Pickup, this, drop.item.GetDefaultObject()->itemId, (float)drop.quantity);
+		}
+	}
+}
+
+bool AFirstRPGCharacter::RemoveFromInventory(ADefaultItem* _item)
+{
+	if (!inventory.RemoveItem(_item))
+	{
+		return false;
+	}
+
+	if (_item != nullptr && !inventory.itemList.Contains(_item))
+	{
+		_item->RemoveHolder(this);
+	}
+	return true;
+}
+
+void AFirstRPGCharacter::OnHeldItemChanged(const ADefaultItem* _item)
+{
+	inventory.RekeyItem(_item);
+}
+
+void AFirstRPGCharacter::OnHeldItemEnded()
+{
+	inventory.MarkItemEnded();
 }
\ No newline at end of file
@@ -7,6 +7,8 @@
 #include "Logging/LogMacros.h"
 #include "DefaultWeapon.h"
 #include "DefaultItem.h"
+#include "Inventory.h"
+#include "DamageFormula.h"
 #include "FirstRPGCharacter.generated.h"
 
 
@@ -14,22 +16,11 @@ class USpringArmComponent;
 class UCameraComponent;
 class UInputMappingContext;
 class UInputAction;
+class UDamageFormula;
 struct FInputActionValue;
 
 DECLARE_LOG_CATEGORY_EXTERN(LogTemplateCharacter, Log, All);
 
-USTRUCT(BlueprintType)
-struct FInventory
-{
-	GENERATED_BODY()
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite)
-	float weightLimit;
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite)
-	TArray<ADefaultItem*> itemList;
-};
-
 UCLASS(config=Game)
 class AFirstRPGCharacter : public ACharacter
 {
@@ -97,6 +88,41 @@ class AFirstRPGCharacter : public ACharacter
 
 public:
 	AFirstRPGCharacter();
+
+	//Gaining experience points
+	UFUNCTION(BlueprintCallable, Category = "Stats")
+	void GainExperience(float _expAmount);
+
+	//Healing
+	UFUNCTION(BlueprintCallable, Category = "Health")
+	void Heal(float _healAmount);
+
+	//Damaging
+	UFUNCTION(BlueprintCallable, Category = "Health")
+	void TakeDamage(float _damageAmount);
+
+	//Healing shields
+	UFUNCTION(BlueprintCallable, Category = "Health")
+	void HealArmor(float _healAmount);
+
+	//Punching
+	void Punch();
+
+	//Damage of one hit with the current stats and weapon, from damageFormula
+	UFUNCTION(BlueprintCallable, Category = "Attack")
+	float ComputeHitDamage() const;
+
+	//Adding items to inventory
+	UFUNCTION(BlueprintCallable, Category = "Item")
+	void AddToInventory(ADefaultItem* _item);
+
+	//Removing items from inventory
+	UFUNCTION(BlueprintCallable, Category = "Item")
+	bool RemoveFromInventory(ADefaultItem* _item);
+
+	//Called by held items, so an edit re-sorts only that item's slots and nothing else
+	void OnHeldItemChanged(const ADefaultItem* _item);
+	void OnHeldItemEnded();
 	
 
 protected:
@@ -111,23 +137,11 @@ protected:
 	//Item equipment
 	void EquipItem();
 
-	//Gaining experience points
-	UFUNCTION(BlueprintCallable, Category = "Stats")
-	void GainExperience(float _expAmount);
-
 	//Healing
 	void StartHealing();
-	UFUNCTION(BlueprintCallable, Category = "Health")
-	void Heal(float _healAmount);
 
 	//Damaging
 	void StartDamage();
-	UFUNCTION(BlueprintCallable, Category = "Health")
-	void TakeDamage(float _damageAmount);
-
-	//Healing shields
-	UFUNCTION(BlueprintCallable, Category = "Health")
-	void HealArmor(float _healAmount);
 
 	//Stamina addition and removal
 	void StartPlusStamina();
@@ -135,9 +149,9 @@ protected:
 	void PlusStamina(float _staminaAmount);
 	void MinusStamina(float _staminaAmount);
 
-	//Adding items to inventory
+	//Adding rolled loot to inventory without spawning actors
 	UFUNCTION(BlueprintCallable, Category = "Item")
-	void AddToInventory(ADefaultItem* _item);
+	void AddLootToInventory(const TArray<FLootDrop>& _drops);
 
 	//Zooming in and stopping the zoom
 	void ZoomIn();
@@ -146,9 +160,6 @@ protected:
 	/** Called for looking input */
 	void Look(const FInputActionValue& Value);
 
-	//Punching
-	void Punch();
-
 	//Is character currently punshing?
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Attack")
 	bool hasPunched;
@@ -212,8 +223,12 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon")
 	ADefaultWeapon* currentWeapon;
 
-	//The inventry structure for character
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Inventory")
+	//Formula combining stats and weapon into hit damage
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Attack")
+	UDamageFormula* damageFormula;
+
+	//The inventry structure for character. Read-only to Blueprint so its sorted indices stay in step.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Inventory")
 	FInventory inventory;
 
 protected:
@@ -230,5 +245,9 @@ public:
 	FORCEINLINE class USpringArmComponent* GetCameraBoom() const { return CameraBoom; }
 	/** Returns FollowCamera subobject **/
 	FORCEINLINE class UCameraComponent* GetFollowCamera() const { return FollowCamera; }
+	//Packs the current stats and weapon for the damage formula, so many hits can be evaluated in one batch
+	FDamageHitInput MakeHitInput() const;
+	//Returns the inventory for sorted and filtered views
+	FORCEINLINE const FInventory& GetInventory() const { return inventory; }
 };
 
@@ -0,0 +1,97 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FirstRPGMemoryReport.h"
+#include "FirstRPG.h"
+#include "FirstRPGCharacter.h"
+#include "MyActor.h"
+#include "DefaultItem.h"
+#include "LootTable.h"
+#include "BaseQuest.h"
+#include "HAL/IConsoleManager.h"
+#include "UObject/UObjectIterator.h"
+
+static FAutoConsoleCommand MemReportCommand(
+	TEXT("FirstRPG.MemReport"),
+	TEXT("Logs FirstRPG memory broken down by subsystem LLM tag."),
+	FConsoleCommandDelegate::CreateStatic(&UFirstRPGMemoryReport::LogMemoryReport));
+
+//Unique name of a tag declared in FirstRPG.h, taken from the declaration itself so a renamed tag cannot drift
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+#define FIRSTRPG_LLM_TAG_NAME(_tag) LLM_TAG_NAME(_tag)
+#else
+#define FIRSTRPG_LLM_TAG_NAME(_tag) NAME_None
+#endif
+
+static FSubsystemMemoryEntry MakeEntry(const TCHAR* _subsystem, FName _tagName)
+{
+	FSubsystemMemoryEntry entry;
+	entry.subsystem = _subsystem;
+
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+	if (FLowLevelMemTracker::IsEnabled())
+	{
+		entry.trackedBytes = FLowLevelMemTracker::Get().GetTagAmountForTracker(ELLMTracker::Default, _tagName, ELLMTagSet::None, UE::LLM::ESizeParams::ReportCurrent);
+	}
+#endif
+
+	return entry;
+}
+
+//Adds every live instance of T (skipping class defaults and archetypes) to _entry
+template <typename T>
+static void CountObjects(FSubsystemMemoryEntry& _entry)
+{
+	for (TObjectIterator<T> it; it; ++it)
+	{
+		if (it->HasAnyFlags(RF_ClassDefaultObject | RF_ArchetypeObject))
+		{
+			continue;
+		}
+
+		_entry.objectCount++;
+		_entry.objectBytes += it->GetClass()->GetStructureSize() + it->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+	}
+}
+
+TArray<FSubsystemMemoryEntry> UFirstRPGMemoryReport::GatherMemoryReport()
+{
+	TArray<FSubsystemMemoryEntry> report;
+
+	FSubsystemMemoryEntry& characters = report.Add_GetRef(MakeEntry(TEXT("Characters"), FIRSTRPG_LLM_TAG_NAME(FirstRPG_Characters)));
+	CountObjects<AFirstRPGCharacter>(characters);
+
+	FSubsystemMemoryEntry& enemies = report.Add_GetRef(MakeEntry(TEXT("Enemies"), FIRSTRPG_LLM_TAG_NAME(FirstRPG_Enemies)));
+	CountObjects<AMyActor>(enemies);
+
+	FSubsystemMemoryEntry& items = report.Add_GetRef(MakeEntry(TEXT("Items"), FIRSTRPG_LLM_TAG_NAME(FirstRPG_Items)));
+	CountObjects<ADefaultItem>(items);
+	CountObjects<ULootTable>(items);
+
+	//Inventories live inside characters, so count their slots and heap instead of objects
+	FSubsystemMemoryEntry& inventories = report.Add_GetRef(MakeEntry(TEXT("Inventory"), FIRSTRPG_LLM_TAG_NAME(FirstRPG_Inventory)));
+	for (TObjectIterator<AFirstRPGCharacter> it; it; ++it)
+	{
+		if (!it->HasAnyFlags(RF_ClassDefaultObject | RF_ArchetypeObject))
+		{
+			inventories.objectCount += it->GetInventory().NumSlots();
+			inventories.objectBytes += it->GetInventory().GetAllocatedSize();
+		}
+	}
+
+	FSubsystemMemoryEntry& quests = report.Add_GetRef(MakeEntry(TEXT("Quests"), FIRSTRPG_LLM_TAG_NAME(FirstRPG_Quests)));
+	CountObjects<UBaseQuest>(quests);
+
+	return report;
+}
+
+void UFirstRPGMemoryReport::LogMemoryReport()
+{
+	UE_LOG(LogFirstRPG, Display, TEXT("FirstRPG memory report (LLM bytes are -1 unless run with -llm)"));
+	UE_LOG(LogFirstRPG, Display, TEXT("%-12s %14s %10s %14s"), TEXT("Subsystem"), TEXT("LLM bytes"), TEXT("Objects"), TEXT("Object bytes"));
+
+	for (const FSubsystemMemoryEntry& entry : GatherMemoryReport())
+	{
+		UE_LOG(LogFirstRPG, Display, TEXT("%-12s %14lld %10d %14lld"), *entry.subsystem, entry.trackedBytes, entry.objectCount, entry.objectBytes);
+	}
+}
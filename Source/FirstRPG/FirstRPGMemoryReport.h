@@ -0,0 +1,48 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Kismet/BlueprintFunctionLibrary.h"
+#include "FirstRPGMemoryReport.generated.h"
+
+//Memory attributed to one FirstRPG subsystem
+USTRUCT(BlueprintType)
+struct FSubsystemMemoryEntry
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	FString subsystem;
+
+	//Bytes the Low-Level Memory Tracker charged to the subsystem's tag, -1 when LLM is not running (-llm)
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	int64 trackedBytes = -1;
+
+	//Live objects (or inventory slots) belonging to the subsystem
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	int objectCount = 0;
+
+	//Object sizes plus their exclusive resource size, counted even without LLM
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	int64 objectBytes = 0;
+};
+
+/**
+ * Breaks FirstRPG memory down by the LLM tags declared in FirstRPG.h. Callable from Blueprint,
+ * from automation, or from the console as FirstRPG.MemReport.
+ */
+UCLASS()
+class FIRSTRPG_API UFirstRPGMemoryReport : public UBlueprintFunctionLibrary
+{
+	GENERATED_BODY()
+
+public:
+	UFUNCTION(BlueprintCallable, Category = "Memory")
+	static TArray<FSubsystemMemoryEntry> GatherMemoryReport();
+
+	//Writes the report to the log
+	UFUNCTION(BlueprintCallable, Category = "Memory")
+	static void LogMemoryReport();
+};
@@ -0,0 +1,261 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GameplayScheduler.h"
+#include "FirstRPG.h"
+#include "HAL/IConsoleManager.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "ProfilingDebugging/MiscTrace.h"
+#include "Tasks/Task.h"
+
+DECLARE_STATS_GROUP(TEXT("GameplayScheduler"), STATGROUP_GameplayScheduler, STATCAT_Advanced);
+DECLARE_CYCLE_STAT(TEXT("Scheduler Tick"), STAT_GameplaySchedulerTick, STATGROUP_GameplayScheduler);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Jobs Run"), STAT_GameplayJobsRun, STATGROUP_GameplayScheduler);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Jobs Deferred"), STAT_GameplayJobsDeferred, STATGROUP_GameplayScheduler);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Budget Overruns"), STAT_GameplayBudgetOverruns, STATGROUP_GameplayScheduler);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Budget Used (ms)"), STAT_GameplayBudgetUsedMs, STATGROUP_GameplayScheduler);
+
+CSV_DEFINE_CATEGORY(GameplayScheduler, true);
+
+static TAutoConsoleVariable<float> CVarSchedulerFrameBudgetMs(
+	TEXT("FirstRPG.Scheduler.FrameBudgetMs"),
+	2.0f,
+	TEXT("Milliseconds of deferred gameplay work the scheduler may run per frame."));
+
+static TAutoConsoleVariable<int32> CVarSchedulerAgingFrames(
+	TEXT("FirstRPG.Scheduler.AgingFrames"),
+	30,
+	TEXT("Frames a job may wait before it is promoted to the next priority class."));
+
+void UGameplayScheduler::Schedule(FName _jobType, EGameplayJobPriority _priority, TUniqueFunction<void()>&& _work)
+{
+	check(IsInGameThread());
+
+	Enqueue({ _jobType, _priority, MoveTemp(_work), FPlatformTime::Seconds(), GFrameCounter });
+}
+
+void UGameplayScheduler::ScheduleOnWorker(FName _jobType, EGameplayJobPriority _priority, TUniqueFunction<void()>&& _work, TUniqueFunction<void()>&& _onComplete)
+{
+	check(IsInGameThread());
+
+	const double queuedTime = FPlatformTime::Seconds();
+
+	workerTasks.Add(UE::Tasks::Launch(UE_SOURCE_LOCATION,
+		[this, _jobType, _priority, queuedTime, work = MoveTemp(_work), onComplete = MoveTemp(_onComplete)]() mutable
+		{
+			work();
+
+			//The game thread picks this up on its next tick and runs it inside the budget
+			completedWorkerJobs.Enqueue({ _jobType, _priority, MoveTemp(onComplete), queuedTime, GFrameCounter });
+		}));
+}
+
+void UGameplayScheduler::ScheduleJob(FName _jobType, EGameplayJobPriority _priority, FGameplayJobDynamicDelegate _job)
+{
+	Schedule(_jobType, _priority, [_job]()
+	{
+		_job.ExecuteIfBound();
+	});
+}
+
+FGameplayJobStats UGameplayScheduler::GetJobStats(FName _jobType) const
+{
+	if (const FGameplayJobStats* stats = jobStats.Find(_jobType))
+	{
+		return *stats;
+	}
+	return FGameplayJobStats();
+}
+
+int UGameplayScheduler::GetNumPendingJobs() const
+{
+	int numPending = 0;
+	for (const TArray<FPendingJob>& queue : pendingJobs)
+	{
+		numPending += queue.Num();
+	}
+	return numPending;
+}
+
+void UGameplayScheduler::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_GameplaySchedulerTick);
+	TRACE_CPUPROFILER_EVENT_SCOPE(UGameplayScheduler::Tick);
+
+	Super::Tick(DeltaTime);
+
+	FPendingJob completed;
+	while (completedWorkerJobs.Dequeue(completed))
+	{
+		Enqueue(MoveTemp(completed));
+	}
+	workerTasks.RemoveAll([](const UE::Tasks::FTask& _task) { return _task.IsCompleted(); });
+
+	AgePendingJobs();
+
+	const double frameStart = FPlatformTime::Seconds();
+	const double budgetSeconds = FMath::Max(0.0f, CVarSchedulerFrameBudgetMs.GetValueOnGameThread()) / 1000.0;
+	int numRun = 0;
+	int numNonCriticalRun = 0;
+	int numOverruns = 0;
+	bool budgetSpent = false;
+
+	for (int32 priorityIndex = 0; priorityIndex < NumPriorities; ++priorityIndex)
+	{
+		TArray<FPendingJob>& queue = pendingJobs[priorityIndex];
+		const bool isCritical = priorityIndex == (int32)EGameplayJobPriority::E_Critical;
+
+		//Jobs can schedule more jobs, so only run what was queued when we got here
+		const int32 numQueued = queue.Num();
+		int32 numTaken = 0;
+		while (numTaken < numQueued)
+		{
+			//Always let one non-critical job through so a busy frame cannot stall the queue forever
+			const bool overBudget = FPlatformTime::Seconds() - frameStart >= budgetSeconds;
+			if (!isCritical && overBudget && numNonCriticalRun > 0)
+			{
+				budgetSpent = true;
+				break;
+			}
+
+			FPendingJob job = MoveTemp(queue[numTaken]);
+			++numTaken;
+
+			if (RunJob(job, frameStart, budgetSeconds))
+			{
+				++numOverruns;
+			}
+			++numRun;
+			if (!isCritical)
+			{
+				++numNonCriticalRun;
+			}
+		}
+		queue.RemoveAt(0, numTaken, false);
+
+		if (budgetSpent)
+		{
+			break;
+		}
+	}
+
+	const float budgetUsedMs = (float)((FPlatformTime::Seconds() - frameStart) * 1000.0);
+
+	SET_DWORD_STAT(STAT_GameplayJobsRun, numRun);
+	SET_DWORD_STAT(STAT_GameplayJobsDeferred, GetNumPendingJobs());
+	SET_DWORD_STAT(STAT_GameplayBudgetOverruns, numOverruns);
+	SET_FLOAT_STAT(STAT_GameplayBudgetUsedMs, budgetUsedMs);
+
+	CSV_CUSTOM_STAT(GameplayScheduler, BudgetUsedMs, budgetUsedMs, ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(GameplayScheduler, JobsRun, numRun, ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(GameplayScheduler, JobsDeferred, GetNumPendingJobs(), ECsvCustomStatOp::Set);
+}
+
+TStatId UGameplayScheduler::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UGameplayScheduler, STATGROUP_Tickables);
+}
+
+void UGameplayScheduler::Deinitialize()
+{
+	//Worker lambdas hold this pointer, so they must all be done before we go away
+	UE::Tasks::Wait(workerTasks);
+	workerTasks.Empty();
+	completedWorkerJobs.Empty();
+
+	for (TArray<FPendingJob>& queue : pendingJobs)
+	{
+		queue.Empty();
+	}
+
+	Super::Deinitialize();
+}
+
+void UGameplayScheduler::Enqueue(FPendingJob&& _job)
+{
+	pendingJobs[(int32)_job.priority].Add(MoveTemp(_job));
+}
+
+void UGameplayScheduler::AgePendingJobs()
+{
+	const uint64 agingFrames = (uint64)FMath::Max(1, CVarSchedulerAgingFrames.GetValueOnGameThread());
+
+	//Walk from high to low so a job moves at most one class per frame.
+	//Critical is reserved for explicitly critical work, so aging stops at High.
+	for (int32 priorityIndex = (int32)EGameplayJobPriority::E_High + 1; priorityIndex < NumPriorities; ++priorityIndex)
+	{
+		TArray<FPendingJob>& queue = pendingJobs[priorityIndex];
+		TArray<FPendingJob>& promoteTo = pendingJobs[priorityIndex - 1];
+
+		//Each queue is ordered oldest first, so we can stop at the first job that is not due yet
+		int32 numPromoted = 0;
+		while (numPromoted < queue.Num() && GFrameCounter - queue[numPromoted].queuedFrame >= agingFrames)
+		{
+			FPendingJob& job = queue[numPromoted];
+			job.priority = (EGameplayJobPriority)(priorityIndex - 1);
+			job.queuedFrame = GFrameCounter;
+			promoteTo.Add(MoveTemp(job));
+			++numPromoted;
+		}
+		queue.RemoveAt(0, numPromoted, false);
+	}
+}
+
+bool UGameplayScheduler::RunJob(FPendingJob& _job, double _frameStart, double _budgetSeconds)
+{
+	FGameplayJobStats& stats = FindOrAddStats(_job.jobType);
+
+	const double runStart = FPlatformTime::Seconds();
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE_TEXT(*stats.scopeName);
+		if (_job.work)
+		{
+			_job.work();
+		}
+	}
+	const double runEnd = FPlatformTime::Seconds();
+
+	const float latencyMs = (float)((runStart - _job.queuedTime) * 1000.0);
+	const float runMs = (float)((runEnd - runStart) * 1000.0);
+	stats.runCount++;
+	stats.averageLatencyMs += (latencyMs - stats.averageLatencyMs) / stats.runCount;
+	stats.averageRunMs += (runMs - stats.averageRunMs) / stats.runCount;
+	stats.maxLatencyMs = FMath::Max(stats.maxLatencyMs, latencyMs);
+
+	//Every job that finishes past the budget counts, including critical jobs that started after it was spent.
+	//Only the job that crossed the line gets a bookmark, so a busy frame does not flood the trace.
+	const bool overran = runEnd - _frameStart > _budgetSeconds;
+	if (overran)
+	{
+		stats.overrunCount++;
+		if (runStart - _frameStart <= _budgetSeconds)
+		{
+			TRACE_BOOKMARK(TEXT("GameplayScheduler overrun: %s"), *stats.scopeName);
+		}
+	}
+
+#if CSV_PROFILER
+	FCsvProfiler::RecordCustomStat(stats.latencyStatName, CSV_CATEGORY_INDEX(GameplayScheduler), latencyMs, ECsvCustomStatOp::Max);
+	if (overran)
+	{
+		FCsvProfiler::RecordCustomStat(stats.overrunStatName, CSV_CATEGORY_INDEX(GameplayScheduler), 1, ECsvCustomStatOp::Accumulate);
+	}
+#endif
+
+	return overran;
+}
+
+FGameplayJobStats& UGameplayScheduler::FindOrAddStats(FName _jobType)
+{
+	if (FGameplayJobStats* stats = jobStats.Find(_jobType))
+	{
+		return *stats;
+	}
+
+	FGameplayJobStats& stats = jobStats.Add(_jobType);
+	stats.scopeName = FString::Printf(TEXT("GameplayJob_%s"), *_jobType.ToString());
+	stats.latencyStatName = FName(*(_jobType.ToString() + TEXT("_LatencyMs")));
+	stats.overrunStatName = FName(*(_jobType.ToString() + TEXT("_Overruns")));
+	return stats;
+}
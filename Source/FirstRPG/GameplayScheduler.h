@@ -0,0 +1,119 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Containers/Queue.h"
+#include "Tasks/Task.h"
+#include "GameplayScheduler.generated.h"
+
+/**
+ * Runs deferred gameplay work (quest evaluation, inventory upkeep, loot rolls, AI decisions)
+ * inside a per-frame millisecond budget instead of all at once on the frame it was requested.
+ */
+
+UENUM(BlueprintType)
+enum class EGameplayJobPriority : uint8
+{
+	E_Critical		UMETA(DisplayName = "CRITICAL"),
+	E_High			UMETA(DisplayName = "HIGH"),
+	E_Normal		UMETA(DisplayName = "NORMAL"),
+	E_Low			UMETA(DisplayName = "LOW")
+};
+
+//Latency and budget figures gathered for one job type
+USTRUCT(BlueprintType)
+struct FGameplayJobStats
+{
+	GENERATED_BODY()
+
+public:
+	//How many jobs of this type have run
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	int runCount = 0;
+
+	//Time between scheduling and running, averaged over every run
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	float averageLatencyMs = 0.0f;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	float maxLatencyMs = 0.0f;
+
+	//Time spent inside the job itself
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	float averageRunMs = 0.0f;
+
+	//Runs that pushed the frame past its budget
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	int overrunCount = 0;
+
+	//Cached names so the hot path never builds strings
+	FString scopeName;
+	FName latencyStatName;
+	FName overrunStatName;
+};
+
+DECLARE_DYNAMIC_DELEGATE(FGameplayJobDynamicDelegate);
+
+UCLASS()
+class FIRSTRPG_API UGameplayScheduler : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	//Queues game-thread work to run inside the frame budget. Critical jobs always run on the next tick.
+	void Schedule(FName _jobType, EGameplayJobPriority _priority, TUniqueFunction<void()>&& _work);
+
+	//Runs pure-data work on a worker thread, then queues _onComplete back on the game thread at _priority.
+	//_work must not touch UObjects.
+	void ScheduleOnWorker(FName _jobType, EGameplayJobPriority _priority, TUniqueFunction<void()>&& _work, TUniqueFunction<void()>&& _onComplete);
+
+	//Blueprint entry point for deferring graph work such as quest evaluation
+	UFUNCTION(BlueprintCallable, Category = "Scheduler")
+	void ScheduleJob(FName _jobType, EGameplayJobPriority _priority, FGameplayJobDynamicDelegate _job);
+
+	UFUNCTION(BlueprintCallable, Category = "Scheduler")
+	FGameplayJobStats GetJobStats(FName _jobType) const;
+
+	UFUNCTION(BlueprintCallable, Category = "Scheduler")
+	int GetNumPendingJobs() const;
+
+	// UTickableWorldSubsystem interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual void Deinitialize() override;
+
+private:
+	struct FPendingJob
+	{
+		FName jobType;
+		EGameplayJobPriority priority;
+		TUniqueFunction<void()> work;
+		double queuedTime;
+		uint64 queuedFrame;
+	};
+
+	static constexpr int32 NumPriorities = 4;
+
+	void Enqueue(FPendingJob&& _job);
+
+	//Promotes jobs that have waited too long into the next priority class so they are not starved
+	void AgePendingJobs();
+
+	//Runs a single job and records its stats; returns true if it finished past the budget
+	bool RunJob(FPendingJob& _job, double _frameStart, double _budgetSeconds);
+
+	FGameplayJobStats& FindOrAddStats(FName _jobType);
+
+	//One FIFO per priority class, highest priority first
+	TArray<FPendingJob> pendingJobs[NumPriorities];
+
+	//Worker jobs that finished and are waiting to hand their results back to the game thread
+	TQueue<FPendingJob, EQueueMode::Mpsc> completedWorkerJobs;
+
+	//Worker tasks still in flight, waited on when the world goes away
+	TArray<UE::Tasks::FTask> workerTasks;
+
+	TMap<FName, FGameplayJobStats> jobStats;
+};
@@ -0,0 +1,518 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GameplayTelemetry.h"
+#include "FirstRPG.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/Compression.h"
+#include "Misc/DateTime.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+std::atomic<bool> FGameplayTelemetry::recording(false);
+
+static TAutoConsoleVariable<int32> CVarTelemetryMaxFileMB(
+	TEXT("FirstRPG.Telemetry.MaxFileMB"),
+	32,
+	TEXT("Size at which the telemetry file is closed and a new one started."));
+
+static TAutoConsoleVariable<int32> CVarTelemetryMaxFiles(
+	TEXT("FirstRPG.Telemetry.MaxFiles"),
+	10,
+	TEXT("Telemetry files kept in Saved/Telemetry; the oldest are deleted beyond this."));
+
+static FAutoConsoleCommand TelemetryStartCommand(
+	TEXT("FirstRPG.Telemetry.Start"),
+	TEXT("Starts recording gameplay telemetry to Saved/Telemetry."),
+	FConsoleCommandDelegate::CreateStatic(&FGameplayTelemetry::Start));
+
+static FAutoConsoleCommand TelemetryStopCommand(
+	TEXT("FirstRPG.Telemetry.Stop"),
+	TEXT("Stops recording gameplay telemetry and flushes what is buffered."),
+	FConsoleCommandDelegate::CreateStatic(&FGameplayTelemetry::Stop));
+
+namespace GameplayTelemetry
+{
+	static const uint64 FileMagic = 0x314D4C5447505246ull;	//"FRPGTLM1"
+	static const uint32 BlockMagic = 0x4B4C4254;			//"TBLK"
+	static const uint32 FileVersion = 1;
+
+	//Records gathered before a block is compressed and written, and the longest they wait
+	static const int32 RecordsPerBlock = 4096;
+	static const double FlushIntervalSeconds = 1.0;
+
+	//Must be a power of two
+	static const uint32 RingCapacity = 1 << 16;
+
+	//Largest block the decoder will allocate for: a full block of records, each with a new name of up to
+	//NAME_SIZE characters. Anything bigger in a file header is corruption.
+	static const uint32 MaxBlockBytes = RecordsPerBlock * (sizeof(FTelemetryRecord) + 2 * sizeof(uint32) + NAME_SIZE * sizeof(TCHAR));
+}
+
+/**
+ * Bounded multi-producer, single-consumer ring (after Dmitry Vyukov's bounded MPMC queue). Each cell
+ * carries a sequence number saying whose turn it is, so producers only contend on one counter and
+ * never wait on each other: a full ring makes Push fail rather than block.
+ */
+class FTelemetryRing
+{
+public:
+	FTelemetryRing()
+	{
+		cells = new FCell[GameplayTelemetry::RingCapacity];
+		for (uint32 i = 0; i < GameplayTelemetry::RingCapacity; i++)
+		{
+			cells[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	~FTelemetryRing()
+	{
+		delete[] cells;
+	}
+
+	bool Push(const FTelemetryRecord& _record)
+	{
+		uint32 position = enqueuePosition.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			FCell& cell = cells[position & Mask];
+			const uint32 sequence = cell.sequence.load(std::memory_order_acquire);
+			const int32 difference = (int32)(sequence - position);
+			if (difference == 0)
+			{
+				if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					cell.record = _record;
+					cell.sequence.store(position + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (difference < 0)
+			{
+				dropped.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+			else
+			{
+				position = enqueuePosition.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	//Writer thread only
+	bool Pop(FTelemetryRecord& _outRecord)
+	{
+		FCell& cell = cells[dequeuePosition & Mask];
+		if ((int32)(cell.sequence.load(std::memory_order_acquire) - (dequeuePosition + 1)) < 0)
+		{
+			return false;
+		}
+
+		_outRecord = cell.record;
+		cell.sequence.store(dequeuePosition + GameplayTelemetry::RingCapacity, std::memory_order_release);
+		dequeuePosition++;
+		return true;
+	}
+
+	uint64 GetNumDropped() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+	static const uint32 Mask = GameplayTelemetry::RingCapacity - 1;
+
+	struct FCell
+	{
+		std::atomic<uint32> sequence;
+		FTelemetryRecord record;
+	};
+
+	FCell* cells;
+
+	//Producers hammer this counter and the consumer its own, so keep them on separate cache lines
+	alignas(PLATFORM_CACHE_LINE_SIZE) std::atomic<uint32> enqueuePosition{ 0 };
+	alignas(PLATFORM_CACHE_LINE_SIZE) uint32 dequeuePosition = 0;
+	alignas(PLATFORM_CACHE_LINE_SIZE) std::atomic<uint64> dropped{ 0 };
+};
+
+//Drains the ring on its own thread and owns the files
+class FTelemetryWriter : public FRunnable
+{
+public:
+	explicit FTelemetryWriter(FTelemetryRing& _ring)
+		: ring(_ring)
+	{
+		wakeEvent = FPlatformProcess::GetSynchEventFromPool(false);
+		directory = FPaths::ProjectSavedDir() / TEXT("Telemetry");
+		sessionName = FDateTime::Now().ToString(TEXT("%Y%m%d-%H%M%S-%s"));
+	}
+
+	virtual ~FTelemetryWriter() override
+	{
+		FPlatformProcess::ReturnSynchEventToPool(wakeEvent);
+	}
+
+	virtual uint32 Run() override
+	{
+		double lastFlush = FPlatformTime::Seconds();
+		while (!stopRequested.load(std::memory_order_relaxed))
+		{
+			wakeEvent->Wait(FTimespan::FromMilliseconds(50.0));
+
+			Drain();
+			if (records.Num() >= GameplayTelemetry::RecordsPerBlock || FPlatformTime::Seconds() - lastFlush >= GameplayTelemetry::FlushIntervalSeconds)
+			{
+				WriteBlock();
+				lastFlush = FPlatformTime::Seconds();
+			}
+		}
+
+		Drain();
+		WriteBlock();
+		CloseFile();
+		return 0;
+	}
+
+	virtual void Stop() override
+	{
+		stopRequested.store(true, std::memory_order_relaxed);
+		wakeEvent->Trigger();
+	}
+
+private:
+	void Drain()
+	{
+		FTelemetryRecord record;
+		while (ring.Pop(record))
+		{
+			records.Add(record);
+			if (records.Num() >= GameplayTelemetry::RecordsPerBlock)
+			{
+				WriteBlock();
+			}
+		}
+	}
+
+	void WriteBlock()
+	{
+		if (records.Num() == 0)
+		{
+			return;
+		}
+
+		if (file == nullptr && !OpenFile())
+		{
+			records.Reset();
+			return;
+		}
+
+		//Each file carries the names it uses, so any one of them decodes on its own
+		TArray<uint8> payload;
+		FMemoryWriter payloadWriter(payload);
+		TArray<uint32> newNames;
+		for (const FTelemetryRecord& record : records)
+		{
+			bool alreadyWritten = false;
+			writtenNames.Add(record.nameId, &alreadyWritten);
+			if (!alreadyWritten)
+			{
+				newNames.Add(record.nameId);
+			}
+		}
+		for (uint32 nameId : newNames)
+		{
+			FString name = FName::CreateFromDisplayId(FNameEntryId::FromUnstableInt(nameId), NAME_NO_NUMBER_INTERNAL).ToString();
+			payloadWriter << nameId;
+			payloadWriter << name;
+		}
+		payloadWriter.Serialize(records.GetData(), records.Num() * sizeof(FTelemetryRecord));
+
+		int32 compressedSize = FCompression::CompressMemoryBound(NAME_Zlib, payload.Num());
+		compressed.SetNumUninitialized(compressedSize, false);
+		if (!FCompression::CompressMemory(NAME_Zlib, compressed.GetData(), compressedSize, payload.GetData(), payload.Num()))
+		{
+			UE_LOG(LogFirstRPG, Warning, TEXT("Telemetry: failed to compress %d records, dropping them"), records.Num());
+			records.Reset();
+			return;
+		}
+
+		uint32 blockMagic = GameplayTelemetry::BlockMagic;
+		uint32 numNames = newNames.Num();
+		uint32 numRecords = records.Num();
+		uint32 uncompressedBytes = payload.Num();
+		uint32 compressedBytes = compressedSize;
+		*file << blockMagic << numNames << numRecords << uncompressedBytes << compressedBytes;
+		file->Serialize(compressed.GetData(), compressedSize);
+		records.Reset();
+
+		if (file->Tell() >= (int64)FMath::Max(1, CVarTelemetryMaxFileMB.GetValueOnAnyThread()) * 1024 * 1024)
+		{
+			CloseFile();
+		}
+	}
+
+	bool OpenFile()
+	{
+		IFileManager& fileManager = IFileManager::Get();
+		fileManager.MakeDirectory(*directory, true);
+
+		const FString path = directory / FString::Printf(TEXT("Telemetry_%s_%03d.frtl"), *sessionName, fileIndex++);
+		file = fileManager.CreateFileWriter(*path);
+		if (file == nullptr)
+		{
+			UE_LOG(LogFirstRPG, Warning, TEXT("Telemetry: could not open %s"), *path);
+			return false;
+		}
+
+		uint64 magic = GameplayTelemetry::FileMagic;
+		uint32 version = GameplayTelemetry::FileVersion;
+		uint32 recordSize = sizeof(FTelemetryRecord);
+		double secondsPerCycle = FPlatformTime::GetSecondsPerCycle64();
+		uint64 startCycles = FPlatformTime::Cycles64();
+		*file << magic << version << recordSize << secondsPerCycle << startCycles;
+
+		writtenNames.Reset();
+		DeleteOldFiles();
+		return true;
+	}
+
+	void CloseFile()
+	{
+		if (file != nullptr)
+		{
+			file->Close();
+			delete file;
+			file = nullptr;
+		}
+	}
+
+	void DeleteOldFiles()
+	{
+		//Timestamped names sort oldest first
+		TArray<FString> files;
+		IFileManager::Get().FindFiles(files, *(directory / TEXT("*.frtl")), true, false);
+		files.Sort();
+
+		const int32 maxFiles = FMath::Max(1, CVarTelemetryMaxFiles.GetValueOnAnyThread());
+		for (int32 i = 0; i < files.Num() - maxFiles; i++)
+		{
+			IFileManager::Get().Delete(*(directory / files[i]));
+		}
+	}
+
+	FTelemetryRing& ring;
+	FEvent* wakeEvent = nullptr;
+	std::atomic<bool> stopRequested{ false };
+
+	FString directory;
+	FString sessionName;
+	int32 fileIndex = 0;
+	FArchive* file = nullptr;
+
+	TArray<FTelemetryRecord> records;
+	TArray<uint8> compressed;
+	TSet<uint32> writtenNames;
+};
+
+//Created on first Start and never freed: a producer that saw recording just before Stop, or a worker still
+//running at module shutdown, may be inside Push at any moment, so there is no safe point to delete it
+static std::atomic<FTelemetryRing*> TelemetryRing(nullptr);
+static FTelemetryWriter* TelemetryWriter = nullptr;
+static FRunnableThread* TelemetryThread = nullptr;
+
+void FGameplayTelemetry::Start()
+{
+	check(IsInGameThread());
+
+	if (TelemetryThread != nullptr)
+	{
+		return;
+	}
+
+	FTelemetryRing* ring = TelemetryRing.load(std::memory_order_acquire);
+	if (ring == nullptr)
+	{
+		ring = new FTelemetryRing();
+		TelemetryRing.store(ring, std::memory_order_release);
+	}
+
+	//Records pushed after the last session's final drain belong to that session, not this file.
+	//No writer thread is running, so the game thread is the ring's only consumer here.
+	FTelemetryRecord leftover;
+	while (ring->Pop(leftover))
+	{
+	}
+
+	TelemetryWriter = new FTelemetryWriter(*ring);
+	TelemetryThread = FRunnableThread::Create(TelemetryWriter, TEXT("FirstRPGTelemetry"), 0, TPri_BelowNormal);
+	if (TelemetryThread == nullptr)
+	{
+		delete TelemetryWriter;
+		TelemetryWriter = nullptr;
+		UE_LOG(LogFirstRPG, Warning, TEXT("Telemetry: could not start the writer thread"));
+		return;
+	}
+
+	recording.store(true, std::memory_order_relaxed);
+	UE_LOG(LogFirstRPG, Display, TEXT("Telemetry recording to %s"), *(FPaths::ProjectSavedDir() / TEXT("Telemetry")));
+}
+
+void FGameplayTelemetry::Stop()
+{
+	check(IsInGameThread());
+
+	recording.store(false, std::memory_order_relaxed);
+
+	if (TelemetryThread != nullptr)
+	{
+		TelemetryThread->Kill(true);
+		delete TelemetryThread;
+		TelemetryThread = nullptr;
+		delete TelemetryWriter;
+		TelemetryWriter = nullptr;
+
+		UE_LOG(LogFirstRPG, Display, TEXT("Telemetry stopped, %llu records dropped"), GetNumDropped());
+	}
+}
+
+void FGameplayTelemetry::StartupModule()
+{
+	if (FParse::Param(FCommandLine::Get(), TEXT("FirstRPGTelemetry")))
+	{
+		Start();
+	}
+}
+
+void FGameplayTelemetry::ShutdownModule()
+{
+	//The ring is left allocated on purpose, see TelemetryRing
+	Stop();
+}
+
+uint64 FGameplayTelemetry::GetNumDropped()
+{
+	const FTelemetryRing* ring = TelemetryRing.load(std::memory_order_acquire);
+	return ring != nullptr ? ring->GetNumDropped() : 0;
+}
+
+void FGameplayTelemetry::Push(ETelemetryEvent _type, const UObject* _subject, FName _name, float _value0, float _value1)
+{
+	FTelemetryRecord record;
+	record.cycles = FPlatformTime::Cycles64();
+	record.frame = (uint32)GFrameCounter;
+	record.subjectId = _subject != nullptr ? _subject->GetUniqueID() : 0;
+	record.nameId = _name.GetDisplayIndex().ToUnstableInt();
+	record.value0 = _value0;
+	record.value1 = _value1;
+	record.type = _type;
+	FMemory::Memzero(record.padding);
+
+	//Null only if Record raced a first Start that has not published the ring yet
+	if (FTelemetryRing* ring = TelemetryRing.load(std::memory_order_acquire))
+	{
+		ring->Push(record);
+	}
+}
+
+const TCHAR* FGameplayTelemetry::GetEventName(ETelemetryEvent _type)
+{
+	switch (_type)
+	{
+	case ETelemetryEvent::Damage:			return TEXT("Damage");
+	case ETelemetryEvent::Kill:				return TEXT("Kill");
+	case ETelemetryEvent::Pickup:			return TEXT("Pickup");
+	case ETelemetryEvent::LevelUp:			return TEXT("LevelUp");
+	case ETelemetryEvent::QuestObjective:	return TEXT("QuestObjective");
+	default:								return TEXT("Unknown");
+	}
+}
+
+bool FGameplayTelemetry::DecodeFile(const FString& _path, TFunctionRef<void(const FTelemetryRecord& _record, double _seconds, const FString& _name)> _visitor)
+{
+	TUniquePtr<FArchive> file(IFileManager::Get().CreateFileReader(*_path));
+	if (!file.IsValid())
+	{
+		return false;
+	}
+
+	uint64 magic = 0;
+	uint32 version = 0;
+	uint32 recordSize = 0;
+	double secondsPerCycle = 0.0;
+	uint64 startCycles = 0;
+	*file << magic << version << recordSize << secondsPerCycle << startCycles;
+	if (magic != GameplayTelemetry::FileMagic || version != GameplayTelemetry::FileVersion || recordSize != sizeof(FTelemetryRecord))
+	{
+		UE_LOG(LogFirstRPG, Error, TEXT("%s is not a telemetry file this build can read"), *_path);
+		return false;
+	}
+
+	TMap<uint32, FString> names;
+	TArray<uint8> compressed;
+	TArray<uint8> payload;
+
+	while (file->Tell() < file->TotalSize())
+	{
+		uint32 blockMagic = 0;
+		uint32 numNames = 0;
+		uint32 numRecords = 0;
+		uint32 uncompressedBytes = 0;
+		uint32 compressedBytes = 0;
+		*file << blockMagic << numNames << numRecords << uncompressedBytes << compressedBytes;
+
+		//A file cut off mid-block (crash, kill) still decodes up to the last whole block
+		if (blockMagic != GameplayTelemetry::BlockMagic || file->IsError() || file->Tell() + compressedBytes > file->TotalSize())
+		{
+			UE_LOG(LogFirstRPG, Warning, TEXT("%s: truncated block at offset %lld, stopping"), *_path, file->Tell());
+			break;
+		}
+
+		//Sizes come from the file, so check them before allocating for them
+		if (numRecords > (uint32)GameplayTelemetry::RecordsPerBlock || numNames > numRecords
+			|| uncompressedBytes > GameplayTelemetry::MaxBlockBytes || compressedBytes > GameplayTelemetry::MaxBlockBytes)
+		{
+			UE_LOG(LogFirstRPG, Warning, TEXT("%s: block at offset %lld has impossible sizes, stopping"), *_path, file->Tell());
+			break;
+		}
+
+		compressed.SetNumUninitialized(compressedBytes, false);
+		payload.SetNumUninitialized(uncompressedBytes, false);
+		file->Serialize(compressed.GetData(), compressedBytes);
+		if (!FCompression::UncompressMemory(NAME_Zlib, payload.GetData(), uncompressedBytes, compressed.GetData(), compressedBytes))
+		{
+			UE_LOG(LogFirstRPG, Warning, TEXT("%s: could not decompress block, stopping"), *_path);
+			break;
+		}
+
+		FMemoryReader payloadReader(payload);
+		for (uint32 i = 0; i < numNames; i++)
+		{
+			uint32 nameId = 0;
+			FString name;
+			payloadReader << nameId;
+			payloadReader << name;
+			names.Add(nameId, MoveTemp(name));
+		}
+
+		if (payloadReader.IsError() || payloadReader.Tell() + (int64)numRecords * sizeof(FTelemetryRecord) > payload.Num())
+		{
+			UE_LOG(LogFirstRPG, Warning, TEXT("%s: block shorter than its record count, stopping"), *_path);
+			break;
+		}
+
+		//The records follow variable-length names, so they are copied out rather than read in place unaligned
+		const uint8* recordBytes = payload.GetData() + payloadReader.Tell();
+		for (uint32 i = 0; i < numRecords; i++)
+		{
+			FTelemetryRecord record;
+			FMemory::Memcpy(&record, recordBytes + i * sizeof(FTelemetryRecord), sizeof(FTelemetryRecord));
+			const FString* name = names.Find(record.nameId);
+			_visitor(record, (double)(int64)(record.cycles - startCycles) * secondsPerCycle, name != nullptr ? *name : FString());
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+
+/**
+ * Binary gameplay event log for balance and perf analysis. Any thread can record; a record is
+ * 32 bytes copied into a lock-free ring, with no allocation, formatting or locking on the caller.
+ * A background thread drains the ring, compresses blocks of records and appends them to rotating
+ * files under Saved/Telemetry. Decode them with the TelemetryDecode commandlet.
+ *
+ * Off by default; start with -FirstRPGTelemetry on the command line or FirstRPG.Telemetry.Start.
+ */
+
+enum class ETelemetryEvent : uint8
+{
+	Damage,				//value0 = damage, value1 = health left
+	Kill,				//name = class of what died
+	Pickup,				//name = item id or collectible class, value0 = quantity
+	LevelUp,			//value0 = new level
+	QuestObjective		//name = quest id, value0 = objective index, value1 = progress
+};
+
+//One event as it sits in the ring and on disk
+struct FTelemetryRecord
+{
+	uint64 cycles;
+	uint32 frame;
+
+	//UObject unique id of whoever the event happened to
+	uint32 subjectId;
+
+	//FName display index; the writer stores the string once per file. Name numbers are not kept.
+	uint32 nameId;
+
+	float value0;
+	float value1;
+	ETelemetryEvent type;
+	uint8 padding[3];
+};
+static_assert(sizeof(FTelemetryRecord) == 32, "Telemetry records are written to disk as-is");
+
+class FIRSTRPG_API FGameplayTelemetry
+{
+public:
+	//Game thread only
+	static void Start();
+	static void Stop();
+
+	//Called from StartupModule and ShutdownModule
+	static void StartupModule();
+	static void ShutdownModule();
+
+	static bool IsRecording() { return recording.load(std::memory_order_relaxed); }
+
+	//Safe from any thread. Costs a flag test when recording is off.
+	FORCEINLINE static void Record(ETelemetryEvent _type, const UObject* _subject, FName _name = NAME_None, float _value0 = 0.0f, float _value1 = 0.0f)
+	{
+		if (IsRecording())
+		{
+			Push(_type, _subject, _name, _value0, _value1);
+		}
+	}
+
+	//Records lost because the ring was full
+	static uint64 GetNumDropped();
+
+	//Reads a telemetry file and calls _visitor for every record, with its time in seconds since the file began
+	static bool DecodeFile(const FString& _path, TFunctionRef<void(const FTelemetryRecord& _record, double _seconds, const FString& _name)> _visitor);
+
+	static const TCHAR* GetEventName(ETelemetryEvent _type);
+
+private:
+	static void Push(ETelemetryEvent _type, const UObject* _subject, FName _name, float _value0, float _value1);
+
+	static std::atomic<bool> recording;
+};
@@ -0,0 +1,468 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Inventory.h"
+#include "FirstRPG.h"
+#include "Algo/BinarySearch.h"
+#include "Algo/StableSort.h"
+
+void FInventory::AddItem(ADefaultItem* _item)
+{
+	LLM_SCOPE_BYTAG(FirstRPG_Inventory);
+
+	if (_item == nullptr)
+	{
+		return;
+	}
+
+	CompactItems();
+	itemList.Add(_item);
+	itemKeys.Add(MakeKey(_item));
+	InsertSlot(itemList.Num() - 1);
+	revision++;
+}
+
+bool FInventory::RemoveItem(ADefaultItem* _item)
+{
+	CompactItems();
+
+	const int32 index = itemList.Find(_item);
+	if (index == INDEX_NONE)
+	{
+		return false;
+	}
+
+	RemoveSlot(index);
+	itemList.RemoveAt(index);
+	itemKeys.RemoveAt(index);
+	revision++;
+	return true;
+}
+
+void FInventory::AddStack(const FLootDrop& _drop)
+{
+	LLM_SCOPE_BYTAG(FirstRPG_Inventory);
+
+	if (_drop.item == nullptr || _drop.quantity <= 0)
+	{
+		return;
+	}
+
+	//Quantity does not affect any sort key, so topping up an existing stack leaves the indices alone
+	if (FLootDrop* stack = itemStacks.FindByPredicate([&_drop](const FLootDrop& _stack) { return _stack.item == _drop.item; }))
+	{
+		stack->quantity += _drop.quantity;
+		revision++;
+		return;
+	}
+
+	CompactItems();
+	itemStacks.Add(_drop);
+	stackKeys.Add(MakeKey(_drop.item.GetDefaultObject()));
+	InsertSlot(StackToSlot(itemStacks.Num() - 1));
+	revision++;
+}
+
+bool FInventory::RemoveStack(TSubclassOf<ADefaultItem> _item, int _quantity)
+{
+	const int32 index = itemStacks.IndexOfByPredicate([&_item](const FLootDrop& _stack) { return _stack.item == _item; });
+	if (index == INDEX_NONE || _quantity <= 0 || itemStacks[index].quantity < _quantity)
+	{
+		return false;
+	}
+
+	itemStacks[index].quantity -= _quantity;
+	if (itemStacks[index].quantity <= 0)
+	{
+		CompactItems();
+		RemoveSlot(StackToSlot(index));
+		itemStacks.RemoveAt(index);
+		stackKeys.RemoveAt(index);
+	}
+	revision++;
+	return true;
+}
+
+TArrayView<const int32> FInventory::GetSorted(EInventorySort _sort) const
+{
+	EnsureIndices();
+
+	switch (_sort)
+	{
+	case EInventorySort::E_Weight:
+		return byWeight;
+	case EInventorySort::E_WeaponType:
+		return byWeaponType;
+	default:
+		return byName;
+	}
+}
+
+TArrayView<const int32> FInventory::GetWeaponsOfType(EWeaponType _weaponType) const
+{
+	EnsureIndices();
+
+	const int32 first = Algo::LowerBound(byWeaponType, _weaponType, [this](int32 _slot, EWeaponType _type) { return GetKey(_slot).weaponType < _type; });
+	const int32 last = Algo::UpperBound(byWeaponType, _weaponType, [this](EWeaponType _type, int32 _slot) { return _type < GetKey(_slot).weaponType; });
+	return MakeArrayView(byWeaponType.GetData() + first, last - first);
+}
+
+TArrayView<const int32> FInventory::FindByNamePrefix(const FString& _prefix) const
+{
+	EnsureIndices();
+
+	if (_prefix.IsEmpty())
+	{
+		return byName;
+	}
+
+	//Names sharing a prefix are contiguous in byName, so two binary searches bound them
+	const int32 prefixLen = _prefix.Len();
+	const int32 first = Algo::LowerBound(byName, _prefix, [this, prefixLen](int32 _slot, const FString& _value)
+	{
+		return FCString::Strnicmp(*GetKey(_slot).name.ToString(), *_value, prefixLen) < 0;
+	});
+	const int32 last = Algo::UpperBound(byName, _prefix, [this, prefixLen](const FString& _value, int32 _slot)
+	{
+		return FCString::Strnicmp(*_value, *GetKey(_slot).name.ToString(), prefixLen) < 0;
+	});
+	return MakeArrayView(byName.GetData() + first, last - first);
+}
+
+bool FInventory::IsWeaponOfType(int32 _slot, EWeaponType _weaponType) const
+{
+	EnsureIndices();
+
+	const FSlotKey& key = GetKey(_slot);
+	return key.isWeapon && key.weaponType == _weaponType;
+}
+
+void FInventory::SortSlots(TArray<int32>& _slots, EInventorySort _sort) const
+{
+	EnsureIndices();
+
+	switch (_sort)
+	{
+	case EInventorySort::E_Weight:
+		Algo::StableSort(_slots, [this](int32 _a, int32 _b) { return WeightLess(_a, _b); });
+		break;
+	case EInventorySort::E_WeaponType:
+		_slots.RemoveAll([this](int32 _slot) { return !GetKey(_slot).isWeapon; });
+		Algo::StableSort(_slots, [this](int32 _a, int32 _b) { return WeaponTypeLess(_a, _b); });
+		break;
+	default:
+		Algo::StableSort(_slots, [this](int32 _a, int32 _b) { return NameLess(_a, _b); });
+		break;
+	}
+}
+
+void FInventory::RekeyItem(const ADefaultItem* _item)
+{
+	LLM_SCOPE_BYTAG(FirstRPG_Inventory);
+
+	CompactItems();
+
+	bool changed = false;
+	for (int32 i = 0; i < itemList.Num(); i++)
+	{
+		if (itemList[i] == _item)
+		{
+			//Take the slot out where its old key put it, then insert it under the new one
+			byName.RemoveSingle(i);
+			byWeight.RemoveSingle(i);
+			byWeaponType.RemoveSingle(i);
+			itemKeys[i] = MakeKey(_item);
+			InsertSlot(i);
+			changed = true;
+		}
+	}
+
+	if (changed)
+	{
+		revision++;
+	}
+}
+
+int FInventory::CountItems(FName _itemId) const
+{
+	int count = 0;
+	for (const ADefaultItem* item : itemList)
+	{
+		if (item != nullptr && item->itemId == _itemId)
+		{
+			count++;
+		}
+	}
+	for (const FLootDrop& stack : itemStacks)
+	{
+		if (stack.item != nullptr && stack.item.GetDefaultObject()->itemId == _itemId)
+		{
+			count += stack.quantity;
+		}
+	}
+	return count;
+}
+
+const ADefaultItem* FInventory::GetItemData(int32 _slot) const
+{
+	if (IsStackSlot(_slot))
+	{
+		const int32 stackIndex = SlotToStack(_slot);
+		return itemStacks.IsValidIndex(stackIndex) ? itemStacks[stackIndex].item.GetDefaultObject() : nullptr;
+	}
+	return itemList.IsValidIndex(_slot) ? itemList[_slot] : nullptr;
+}
+
+int FInventory::GetQuantity(int32 _slot) const
+{
+	if (IsStackSlot(_slot))
+	{
+		const int32 stackIndex = SlotToStack(_slot);
+		return itemStacks.IsValidIndex(stackIndex) ? itemStacks[stackIndex].quantity : 0;
+	}
+	return itemList.IsValidIndex(_slot) ? 1 : 0;
+}
+
+SIZE_T FInventory::GetAllocatedSize() const
+{
+	//Key names share their text with the items, so only the key arrays themselves count here
+	return itemList.GetAllocatedSize() + itemStacks.GetAllocatedSize() + itemKeys.GetAllocatedSize() + stackKeys.GetAllocatedSize()
+		+ byName.GetAllocatedSize() + byWeight.GetAllocatedSize() + byWeaponType.GetAllocatedSize();
+}
+
+uint32 FInventory::GetRevision() const
+{
+	//Items that left play are pruned on the next query; doing it here lets views notice
+	EnsureIndices();
+	return revision;
+}
+
+void FInventory::EnsureIndices() const
+{
+	if (itemKeys.Num() != itemList.Num() || stackKeys.Num() != itemStacks.Num() || byName.Num() + numPrunedItems != NumSlots())
+	{
+		RebuildIndices();
+	}
+	else if (hasEndedItems)
+	{
+		PruneEndedItems();
+	}
+}
+
+void FInventory::RebuildIndices() const
+{
+	LLM_SCOPE_BYTAG(FirstRPG_Inventory);
+
+	itemKeys.Reset(itemList.Num());
+	for (const ADefaultItem* item : itemList)
+	{
+		itemKeys.Add(MakeKey(item));
+	}
+	stackKeys.Reset(itemStacks.Num());
+	for (const FLootDrop& stack : itemStacks)
+	{
+		stackKeys.Add(MakeKey(stack.item.GetDefaultObject()));
+	}
+	hasEndedItems = false;
+	numPrunedItems = 0;
+
+	byName.Reset(NumSlots());
+	byWeaponType.Reset();
+
+	for (int32 i = 0; i < itemList.Num(); i++)
+	{
+		if (IsEndedSlot(i))
+		{
+			numPrunedItems++;
+			continue;
+		}
+		byName.Add(i);
+	}
+	for (int32 i = 0; i < itemStacks.Num(); i++)
+	{
+		byName.Add(StackToSlot(i));
+	}
+
+	byWeight = byName;
+	for (int32 slot : byName)
+	{
+		if (GetKey(slot).isWeapon)
+		{
+			byWeaponType.Add(slot);
+		}
+	}
+
+	Algo::StableSort(byName, [this](int32 _a, int32 _b) { return NameLess(_a, _b); });
+	Algo::StableSort(byWeight, [this](int32 _a, int32 _b) { return WeightLess(_a, _b); });
+	Algo::StableSort(byWeaponType, [this](int32 _a, int32 _b) { return WeaponTypeLess(_a, _b); });
+	revision++;
+}
+
+void FInventory::InsertSlot(int32 _slot)
+{
+	//Upper bound keeps equal keys in insertion order, matching what a stable sort would give
+	byName.Insert(_slot, Algo::UpperBound(byName, _slot, [this](int32 _a, int32 _b) { return NameLess(_a, _b); }));
+	byWeight.Insert(_slot, Algo::UpperBound(byWeight, _slot, [this](int32 _a, int32 _b) { return WeightLess(_a, _b); }));
+
+	if (GetKey(_slot).isWeapon)
+	{
+		byWeaponType.Insert(_slot, Algo::UpperBound(byWeaponType, _slot, [this](int32 _a, int32 _b) { return WeaponTypeLess(_a, _b); }));
+	}
+}
+
+void FInventory::RemoveSlot(int32 _slot)
+{
+	//Drop the slot and renumber everything after it in the same array, so order is kept without re-sorting
+	auto removeAndShift = [_slot](TArray<int32>& _index)
+	{
+		int32 write = 0;
+		for (int32 read = 0; read < _index.Num(); read++)
+		{
+			int32 slot = _index[read];
+			if (slot == _slot)
+			{
+				continue;
+			}
+			if (IsStackSlot(_slot) && IsStackSlot(slot) && slot < _slot)
+			{
+				slot++;
+			}
+			else if (!IsStackSlot(_slot) && !IsStackSlot(slot) && slot > _slot)
+			{
+				slot--;
+			}
+			_index[write++] = slot;
+		}
+		_index.SetNum(write, false);
+	};
+
+	removeAndShift(byName);
+	removeAndShift(byWeight);
+	removeAndShift(byWeaponType);
+}
+
+bool FInventory::IsEndedSlot(int32 _slot) const
+{
+	if (IsStackSlot(_slot))
+	{
+		return false;
+	}
+	const ADefaultItem* item = itemList[_slot];
+	return !IsValid(item) || item->HasEndedPlay();
+}
+
+void FInventory::PruneEndedItems() const
+{
+	hasEndedItems = false;
+
+	//RemoveAll keeps the order, so the indices stay sorted without touching the other slots
+	auto isEnded = [this](int32 _slot) { return IsEndedSlot(_slot); };
+	const int32 pruned = byName.RemoveAll(isEnded);
+	if (pruned == 0)
+	{
+		return;
+	}
+	byWeight.RemoveAll(isEnded);
+	byWeaponType.RemoveAll(isEnded);
+
+	numPrunedItems += pruned;
+	revision++;
+}
+
+void FInventory::CompactItems()
+{
+	EnsureIndices();
+	if (numPrunedItems == 0)
+	{
+		return;
+	}
+
+	//Drop ended items from itemList, then renumber the item slots left in the indices in one pass each
+	TArray<int32> newSlots;
+	newSlots.SetNumUninitialized(itemList.Num());
+	int32 write = 0;
+	for (int32 read = 0; read < itemList.Num(); read++)
+	{
+		if (IsEndedSlot(read))
+		{
+			newSlots[read] = INDEX_NONE;
+			continue;
+		}
+		newSlots[read] = write;
+		if (write != read)
+		{
+			itemList[write] = itemList[read];
+			itemKeys[write] = MoveTemp(itemKeys[read]);
+		}
+		write++;
+	}
+	itemList.SetNum(write, false);
+	itemKeys.SetNum(write, false);
+
+	auto renumber = [&newSlots](TArray<int32>& _index)
+	{
+		int32 kept = 0;
+		for (int32 slot : _index)
+		{
+			if (!IsStackSlot(slot))
+			{
+				slot = newSlots[slot];
+				if (slot == INDEX_NONE)
+				{
+					continue;
+				}
+			}
+			_index[kept++] = slot;
+		}
+		_index.SetNum(kept, false);
+	};
+
+	renumber(byName);
+	renumber(byWeight);
+	renumber(byWeaponType);
+	numPrunedItems = 0;
+}
+
+FInventory::FSlotKey FInventory::MakeKey(const ADefaultItem* _item)
+{
+	FSlotKey key;
+	if (IsValid(_item))
+	{
+		key.name = _item->displayName;
+		key.weight = _item->weight;
+		if (const ADefaultWeapon* weapon = Cast<const ADefaultWeapon>(_item))
+		{
+			key.weaponType = weapon->weaponType;
+			key.isWeapon = true;
+		}
+	}
+	return key;
+}
+
+const FInventory::FSlotKey& FInventory::GetKey(int32 _slot) const
+{
+	return IsStackSlot(_slot) ? stackKeys[SlotToStack(_slot)] : itemKeys[_slot];
+}
+
+bool FInventory::NameLess(int32 _a, int32 _b) const
+{
+	//A plain case-insensitive compare of the display strings rather than FText::CompareTo, whose
+	//collation would not keep names sharing a prefix next to each other for FindByNamePrefix
+	return GetKey(_a).name.ToString().Compare(GetKey(_b).name.ToString(), ESearchCase::IgnoreCase) < 0;
+}
+
+bool FInventory::WeightLess(int32 _a, int32 _b) const
+{
+	return GetKey(_a).weight < GetKey(_b).weight;
+}
+
+bool FInventory::WeaponTypeLess(int32 _a, int32 _b) const
+{
+	const EWeaponType typeA = GetKey(_a).weaponType;
+	const EWeaponType typeB = GetKey(_b).weaponType;
+	if (typeA != typeB)
+	{
+		return typeA < typeB;
+	}
+	return NameLess(_a, _b);
+}
@@ -0,0 +1,150 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DefaultItem.h"
+#include "DefaultWeapon.h"
+#include "LootTable.h"
+#include "Inventory.generated.h"
+
+/**
+ * Character inventory. Besides the item arrays it keeps sorted slot indices by name, weight and
+ * weapon type, updated incrementally on every add and remove, so sorted, filtered and searched
+ * views are slices of an existing array rather than a fresh sort.
+ *
+ * A slot is an int32: slots >= 0 index itemList, slots < 0 index itemStacks as -(slot + 1).
+ *
+ * The indices order slots by a snapshot of each item's sort keys taken when the slot was indexed,
+ * so an item being garbage collected or edited in place can never leave a binary search looking
+ * at an unsorted array. An item whose keys change re-keys only its own slots, through the
+ * characters holding it. Items that leave play are dropped from the indices on the next query and
+ * from itemList on the next add or remove. Game thread only.
+ */
+
+UENUM(BlueprintType)
+enum class EInventorySort : uint8
+{
+	E_Name			UMETA(DisplayName = "NAME"),
+	E_Weight		UMETA(DisplayName = "WEIGHT"),
+	E_WeaponType	UMETA(DisplayName = "WEAPON TYPE")
+};
+
+USTRUCT(BlueprintType)
+struct FIRSTRPG_API FInventory
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float weightLimit;
+
+	//Read-only to Blueprint; go through the character's AddToInventory and RemoveFromInventory
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	TArray<ADefaultItem*> itemList;
+
+	//Items held as class and count only, e.g. loot that was never spawned in the world
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	TArray<FLootDrop> itemStacks;
+
+	//Adding and removing items, keeping the indices in step
+	void AddItem(ADefaultItem* _item);
+	bool RemoveItem(ADefaultItem* _item);
+	void AddStack(const FLootDrop& _drop);
+	bool RemoveStack(TSubclassOf<ADefaultItem> _item, int _quantity);
+
+	//All slots in the given order. Sorting by weapon type only returns weapons.
+	TArrayView<const int32> GetSorted(EInventorySort _sort) const;
+
+	//Weapons of one type, sorted by name. Items that are not weapons never appear here.
+	TArrayView<const int32> GetWeaponsOfType(EWeaponType _weaponType) const;
+
+	//Slots whose name starts with _prefix (case-insensitive), sorted by name
+	TArrayView<const int32> FindByNamePrefix(const FString& _prefix) const;
+
+	//Whether the slot is indexed as a weapon of _weaponType, by the same key GetWeaponsOfType uses
+	bool IsWeaponOfType(int32 _slot, EWeaponType _weaponType) const;
+
+	//Puts slots taken from the views above into the given order, e.g. search results by weight.
+	//Like GetSorted, sorting by weapon type drops slots that are not weapons.
+	void SortSlots(TArray<int32>& _slots, EInventorySort _sort) const;
+
+	//How many of one kind of item the inventory holds, matched by itemId
+	int CountItems(FName _itemId) const;
+
+	//Slot helpers
+	int NumSlots() const { return itemList.Num() + itemStacks.Num(); }
+	static bool IsStackSlot(int32 _slot) { return _slot < 0; }
+	static int32 StackToSlot(int32 _stackIndex) { return -(_stackIndex + 1); }
+	static int32 SlotToStack(int32 _slot) { return -(_slot + 1); }
+
+	//The item itself for actor slots, the class defaults for stack slots
+	const ADefaultItem* GetItemData(int32 _slot) const;
+
+	//How many items the slot holds
+	int GetQuantity(int32 _slot) const;
+
+	//Re-sorts the slots holding _item after its name, weight or weapon type changed
+	void RekeyItem(const ADefaultItem* _item);
+
+	//An item in itemList left play; its slots are dropped lazily instead of re-sorting anything
+	void MarkItemEnded() { hasEndedItems = true; }
+
+	//Rebuilds the indices if the arrays were edited directly, and drops items that left play.
+	//Every query calls this first, so callers only need it to move the cost somewhere cheaper.
+	void EnsureIndices() const;
+	void RebuildIndices() const;
+
+	//Heap bytes held by the item arrays and indices
+	SIZE_T GetAllocatedSize() const;
+
+	//Bumped on every change, so views can tell when slots they hold are stale
+	uint32 GetRevision() const;
+
+private:
+	//What a slot is sorted by, copied out of the item when the slot is indexed. The name is the item's
+	//FText, which shares its string with the item and the string table instead of copying it per slot.
+	struct FSlotKey
+	{
+		FText name;
+		float weight = 0.0f;
+		EWeaponType weaponType = EWeaponType::E_Default;
+		bool isWeapon = false;
+	};
+
+	static FSlotKey MakeKey(const ADefaultItem* _item);
+	const FSlotKey& GetKey(int32 _slot) const;
+
+	void InsertSlot(int32 _slot);
+	void RemoveSlot(int32 _slot);
+
+	//Item slots whose item was destroyed or left play
+	bool IsEndedSlot(int32 _slot) const;
+
+	//Takes ended items out of the indices only; itemList keeps them until CompactItems
+	void PruneEndedItems() const;
+
+	//Runs before every edit: brings the indices up to date and removes pruned items from itemList
+	void CompactItems();
+
+	bool NameLess(int32 _a, int32 _b) const;
+	bool WeightLess(int32 _a, int32 _b) const;
+	bool WeaponTypeLess(int32 _a, int32 _b) const;
+
+	//Cached from itemList and itemStacks, so const queries may rebuild them
+	mutable TArray<FSlotKey> itemKeys;
+	mutable TArray<FSlotKey> stackKeys;
+	mutable TArray<int32> byName;
+	mutable TArray<int32> byWeight;
+
+	//Weapons only, sorted by type then name
+	mutable TArray<int32> byWeaponType;
+
+	//Set when a held item leaves play, cleared once its slots are pruned
+	mutable bool hasEndedItems = false;
+
+	//Entries of itemList that are missing from the indices until the next edit compacts them
+	mutable int32 numPrunedItems = 0;
+
+	mutable uint32 revision = 0;
+};
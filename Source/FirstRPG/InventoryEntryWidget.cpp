@@ -0,0 +1,62 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InventoryEntryWidget.h"
+#include "InventoryPanel.h"
+#include "Components/TextBlock.h"
+
+void UInventoryEntryWidget::SetSlot(UInventoryPanel* _panel, int32 _slot)
+{
+	panel = _panel;
+	slot = _slot;
+	hasSlot = true;
+	RefreshEntry();
+}
+
+void UInventoryEntryWidget::ClearSlot()
+{
+	panel = nullptr;
+	hasSlot = false;
+	RefreshEntry();
+}
+
+void UInventoryEntryWidget::RefreshEntry()
+{
+	const FInventory* inventory = hasSlot && panel != nullptr ? panel->GetInventory() : nullptr;
+	const ADefaultItem* item = inventory != nullptr ? inventory->GetItemData(slot) : nullptr;
+	if (item == nullptr)
+	{
+		//Clear what the row showed for its previous slot
+		if (nameText != nullptr)
+		{
+			nameText->SetText(FText::GetEmpty());
+		}
+		if (weightText != nullptr)
+		{
+			weightText->SetText(FText::GetEmpty());
+		}
+		if (quantityText != nullptr)
+		{
+			quantityText->SetText(FText::GetEmpty());
+		}
+		OnEntryRefreshed(FText::GetEmpty(), 0.0f, 0);
+		return;
+	}
+
+	const int quantity = inventory->GetQuantity(slot);
+
+	if (nameText != nullptr)
+	{
+		nameText->SetText(item->displayName);
+	}
+	if (weightText != nullptr)
+	{
+		weightText->SetText(FText::AsNumber(item->weight));
+	}
+	if (quantityText != nullptr)
+	{
+		quantityText->SetText(FText::AsNumber(quantity));
+	}
+
+	OnEntryRefreshed(item->displayName, item->weight, quantity);
+}
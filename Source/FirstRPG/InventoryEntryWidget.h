@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Blueprint/UserWidget.h"
+#include "InventoryEntryWidget.generated.h"
+
+class UInventoryPanel;
+class UTextBlock;
+
+/**
+ * One row of UInventoryPanel. The panel rebinds its few rows to other slots as it scrolls, so a
+ * row reads everything it shows from its current slot and keeps no item state of its own.
+ */
+UCLASS()
+class FIRSTRPG_API UInventoryEntryWidget : public UUserWidget
+{
+	GENERATED_BODY()
+
+public:
+	//Points the row at a slot of the panel's inventory and shows it
+	void SetSlot(UInventoryPanel* _panel, int32 _slot);
+
+	//Leaves the row empty
+	void ClearSlot();
+
+	//Re-reads the item behind the current slot
+	void RefreshEntry();
+
+protected:
+	//Lets the Blueprint react to the row being bound, e.g. to set an icon. An empty row passes an empty name.
+	UFUNCTION(BlueprintImplementableEvent, Category = "Inventory")
+	void OnEntryRefreshed(const FText& _displayName, float _weight, int _quantity);
+
+	UPROPERTY(meta = (BindWidgetOptional))
+	UTextBlock* nameText;
+
+	UPROPERTY(meta = (BindWidgetOptional))
+	UTextBlock* weightText;
+
+	UPROPERTY(meta = (BindWidgetOptional))
+	UTextBlock* quantityText;
+
+private:
+	UPROPERTY()
+	UInventoryPanel* panel;
+
+	//Slot in the panel's inventory, see FInventory. Any int32 is a valid slot, hence hasSlot.
+	int32 slot = 0;
+	bool hasSlot = false;
+};
@@ -0,0 +1,175 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InventoryPanel.h"
+#include "FirstRPG.h"
+#include "InventoryEntryWidget.h"
+#include "FirstRPGCharacter.h"
+#include "Components/PanelWidget.h"
+
+UInventoryPanel::UInventoryPanel(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	entryClass = UInventoryEntryWidget::StaticClass();
+	visibleRows = 12;
+	sortMode = EInventorySort::E_Name;
+}
+
+void UInventoryPanel::SetCharacter(AFirstRPGCharacter* _character)
+{
+	character = _character;
+	scrollOffset = 0;
+	Refresh();
+}
+
+void UInventoryPanel::SetSort(EInventorySort _sort)
+{
+	sortMode = _sort;
+	Refresh();
+}
+
+void UInventoryPanel::SetNameSearch(const FString& _prefix)
+{
+	nameSearch = _prefix;
+	scrollOffset = 0;
+	Refresh();
+}
+
+void UInventoryPanel::SetWeaponTypeFilter(EWeaponType _weaponType)
+{
+	filterByWeaponType = true;
+	weaponTypeFilter = _weaponType;
+	scrollOffset = 0;
+	Refresh();
+}
+
+void UInventoryPanel::ClearWeaponTypeFilter()
+{
+	filterByWeaponType = false;
+	scrollOffset = 0;
+	Refresh();
+}
+
+void UInventoryPanel::Refresh()
+{
+	LLM_SCOPE_BYTAG(FirstRPG_Inventory);
+
+	shownSlots = TArrayView<const int32>();
+	if (const FInventory* inventory = GetInventory())
+	{
+		if (nameSearch.IsEmpty() && !filterByWeaponType)
+		{
+			//Nothing to filter, so the rows read one of the inventory's indices directly
+			shownSlots = inventory->GetSorted(sortMode);
+		}
+		else
+		{
+			//Narrow down with one index view, then put the result in sortMode order. Both filters read
+			//the inventory's indexed keys, so they agree with each other while an item is being edited.
+			if (!nameSearch.IsEmpty())
+			{
+				const TArrayView<const int32> found = inventory->FindByNamePrefix(nameSearch);
+				filteredSlots.Reset();
+				filteredSlots.Append(found.GetData(), found.Num());
+				if (filterByWeaponType)
+				{
+					filteredSlots.RemoveAll([inventory, this](int32 _slot) { return !inventory->IsWeaponOfType(_slot, weaponTypeFilter); });
+				}
+			}
+			else
+			{
+				const TArrayView<const int32> found = inventory->GetWeaponsOfType(weaponTypeFilter);
+				filteredSlots.Reset();
+				filteredSlots.Append(found.GetData(), found.Num());
+			}
+			inventory->SortSlots(filteredSlots, sortMode);
+			shownSlots = filteredSlots;
+		}
+		shownRevision = inventory->GetRevision();
+	}
+
+	UpdateRows();
+}
+
+void UInventoryPanel::SetScrollOffset(int32 _firstRow)
+{
+	scrollOffset = _firstRow;
+
+	//If the inventory changed since the last refresh, shownSlots may point at moved slots
+	const FInventory* inventory = GetInventory();
+	if (inventory != nullptr && inventory->GetRevision() != shownRevision)
+	{
+		Refresh();
+		return;
+	}
+
+	UpdateRows();
+}
+
+void UInventoryPanel::EnsureRows()
+{
+	if (entryClass == nullptr)
+	{
+		return;
+	}
+
+	while (rows.Num() < visibleRows)
+	{
+		UInventoryEntryWidget* row = CreateWidget<UInventoryEntryWidget>(this, entryClass);
+		if (row == nullptr)
+		{
+			return;
+		}
+		if (rowContainer != nullptr)
+		{
+			rowContainer->AddChild(row);
+		}
+		rows.Add(row);
+	}
+}
+
+void UInventoryPanel::UpdateRows()
+{
+	EnsureRows();
+
+	scrollOffset = FMath::Clamp(scrollOffset, 0, FMath::Max(shownSlots.Num() - rows.Num(), 0));
+
+	for (int32 i = 0; i < rows.Num(); i++)
+	{
+		const int32 shownIndex = scrollOffset + i;
+		if (shownSlots.IsValidIndex(shownIndex))
+		{
+			rows[i]->SetSlot(this, shownSlots[shownIndex]);
+			rows[i]->SetVisibility(ESlateVisibility::Visible);
+		}
+		else
+		{
+			//Hidden rather than collapsed, so the rows above keep their place
+			rows[i]->ClearSlot();
+			rows[i]->SetVisibility(ESlateVisibility::Hidden);
+		}
+	}
+}
+
+const FInventory* UInventoryPanel::GetInventory() const
+{
+	return character != nullptr ? &character->GetInventory() : nullptr;
+}
+
+void UInventoryPanel::NativeTick(const FGeometry& MyGeometry, float InDeltaTime)
+{
+	Super::NativeTick(MyGeometry, InDeltaTime);
+
+	const FInventory* inventory = GetInventory();
+	if (inventory != nullptr && inventory->GetRevision() != shownRevision)
+	{
+		Refresh();
+	}
+}
+
+FReply UInventoryPanel::NativeOnMouseWheel(const FGeometry& InGeometry, const FPointerEvent& InMouseEvent)
+{
+	//One row per notch, wheel up scrolls towards the top
+	SetScrollOffset(scrollOffset - FMath::RoundToInt(InMouseEvent.GetWheelDelta()));
+	return FReply::Handled();
+}
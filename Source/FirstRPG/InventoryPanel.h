@@ -0,0 +1,117 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Blueprint/UserWidget.h"
+#include "Inventory.h"
+#include "InventoryPanel.generated.h"
+
+class AFirstRPGCharacter;
+class UInventoryEntryWidget;
+class UPanelWidget;
+
+/**
+ * Inventory window that virtualizes its own rows. It builds visibleRows entry widgets once and,
+ * as the player scrolls, rebinds them to the slots now in view. Rows read straight from the
+ * inventory's sorted indices, so nothing is allocated per item: open time and memory stay flat
+ * however much the character carries.
+ */
+UCLASS()
+class FIRSTRPG_API UInventoryPanel : public UUserWidget
+{
+	GENERATED_BODY()
+
+public:
+	UInventoryPanel(const FObjectInitializer& ObjectInitializer);
+
+	//Shows this character's inventory
+	UFUNCTION(BlueprintCallable, Category = "Inventory")
+	void SetCharacter(AFirstRPGCharacter* _character);
+
+	//Order of the rows, also applied on top of a search or weapon filter
+	UFUNCTION(BlueprintCallable, Category = "Inventory")
+	void SetSort(EInventorySort _sort);
+
+	//Only show items whose name starts with _prefix. An empty prefix clears the search.
+	UFUNCTION(BlueprintCallable, Category = "Inventory")
+	void SetNameSearch(const FString& _prefix);
+
+	//Only show weapons of one type
+	UFUNCTION(BlueprintCallable, Category = "Inventory")
+	void SetWeaponTypeFilter(EWeaponType _weaponType);
+
+	UFUNCTION(BlueprintCallable, Category = "Inventory")
+	void ClearWeaponTypeFilter();
+
+	//Rebuilds the shown slots from the inventory's current indices
+	UFUNCTION(BlueprintCallable, Category = "Inventory")
+	void Refresh();
+
+	//First shown slot at the top row, clamped so the last page stays full. For a scroll bar.
+	UFUNCTION(BlueprintCallable, Category = "Inventory")
+	void SetScrollOffset(int32 _firstRow);
+
+	UFUNCTION(BlueprintPure, Category = "Inventory")
+	int32 GetScrollOffset() const { return scrollOffset; }
+
+	//How many slots pass the current search and filter
+	UFUNCTION(BlueprintPure, Category = "Inventory")
+	int32 GetNumShown() const { return shownSlots.Num(); }
+
+	//Slots that pass the current search and filter, in display order
+	TArrayView<const int32> GetShownSlots() const { return shownSlots; }
+
+	//Entry widgets built so far; never more than visibleRows
+	int32 GetNumRowWidgets() const { return rows.Num(); }
+
+	//Inventory the rows point into, null if there is no character
+	const FInventory* GetInventory() const;
+
+protected:
+	virtual void NativeTick(const FGeometry& MyGeometry, float InDeltaTime) override;
+	virtual FReply NativeOnMouseWheel(const FGeometry& InGeometry, const FPointerEvent& InMouseEvent) override;
+
+	//Box placed in the widget Blueprint that the rows are added to, e.g. a vertical box
+	UPROPERTY(meta = (BindWidget))
+	UPanelWidget* rowContainer;
+
+	//Widget for one row
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Inventory")
+	TSubclassOf<UInventoryEntryWidget> entryClass;
+
+	//Rows on screen at once; the only entry widgets the panel ever builds
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Inventory", meta = (ClampMin = "1"))
+	int32 visibleRows;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Inventory")
+	EInventorySort sortMode;
+
+private:
+	//Builds the row widgets on first use
+	void EnsureRows();
+
+	//Binds each row to the slot now under it
+	void UpdateRows();
+
+	UPROPERTY()
+	AFirstRPGCharacter* character;
+
+	UPROPERTY()
+	TArray<UInventoryEntryWidget*> rows;
+
+	//Either one of the inventory's own indices or filteredSlots
+	TArrayView<const int32> shownSlots;
+
+	//Search and filter results re-sorted by sortMode; keeps its capacity across refreshes
+	TArray<int32> filteredSlots;
+
+	int32 scrollOffset = 0;
+
+	FString nameSearch;
+	bool filterByWeaponType = false;
+	EWeaponType weaponTypeFilter = EWeaponType::E_Default;
+
+	//Inventory revision shownSlots was taken from
+	uint32 shownRevision = 0;
+};
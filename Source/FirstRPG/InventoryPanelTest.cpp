@@ -0,0 +1,108 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "FirstRPG.h"
+#include "FirstRPGCharacter.h"
+#include "DefaultItem.h"
+#include "InventoryPanel.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "UObject/UObjectHash.h"
+
+//Per-slot cost of the item arrays, sort keys and three indices, with room for array slack. Names are
+//shared with the items, so a per-slot string copy would break this at any item count.
+static constexpr SIZE_T MaxInventoryBytesPerItem = 128;
+
+//Opens the inventory panel on 10 to 10,000 items in a throwaway world, without a viewport, and checks
+//that the panel builds the same widgets and objects every time and that inventory memory grows only by a
+//fixed amount per item. Open times are logged for comparison.
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventoryPanelScalingTest, "FirstRPG.Inventory.PanelScaling",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ProductFilter)
+
+bool FInventoryPanelScalingTest::RunTest(const FString& Parameters)
+{
+	UWorld* world = UWorld::CreateWorld(EWorldType::Game, false);
+	FWorldContext& worldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	worldContext.SetCurrentWorld(world);
+
+	int32 firstRowWidgets = INDEX_NONE;
+	int32 firstPanelObjects = INDEX_NONE;
+
+	for (int32 itemCount : { 10, 100, 1000, 10000 })
+	{
+		AFirstRPGCharacter* character = world->SpawnActor<AFirstRPGCharacter>();
+		if (!TestNotNull(TEXT("Character spawned"), character))
+		{
+			break;
+		}
+
+		for (int32 i = 0; i < itemCount; i++)
+		{
+			ADefaultItem* item = world->SpawnActor<ADefaultItem>();
+			item->SetDisplayName(FText::FromString(FString::Printf(TEXT("Item %05d"), (i * 7919) % itemCount)));
+			item->SetWeight((float)(i % 50));
+			character->AddToInventory(item);
+		}
+
+		UInventoryPanel* panel = CreateWidget<UInventoryPanel>(world, UInventoryPanel::StaticClass());
+		if (!TestNotNull(TEXT("Panel created"), panel))
+		{
+			break;
+		}
+
+		const double openStart = FPlatformTime::Seconds();
+		panel->SetCharacter(character);
+		const double openMs = (FPlatformTime::Seconds() - openStart) * 1000.0;
+
+		TArray<UObject*> panelObjects;
+		GetObjectsWithOuter(panel, panelObjects, true);
+
+		const SIZE_T inventoryBytes = character->GetInventory().GetAllocatedSize();
+		AddInfo(FString::Printf(TEXT("%d items: open %.3f ms, %d row widgets, %d panel objects, inventory %llu bytes"),
+			itemCount, openMs, panel->GetNumRowWidgets(), panelObjects.Num(), (uint64)inventoryBytes));
+
+		TestEqual(TEXT("Every slot is shown"), panel->GetNumShown(), itemCount);
+		TestTrue(FString::Printf(TEXT("Inventory stays under %llu bytes per item (%llu)"), (uint64)MaxInventoryBytesPerItem, (uint64)(inventoryBytes / itemCount)),
+			inventoryBytes <= MaxInventoryBytesPerItem * itemCount);
+		if (firstRowWidgets == INDEX_NONE)
+		{
+			firstRowWidgets = panel->GetNumRowWidgets();
+			firstPanelObjects = panelObjects.Num();
+		}
+		else
+		{
+			TestEqual(TEXT("Row widgets do not grow with the inventory"), panel->GetNumRowWidgets(), firstRowWidgets);
+			TestEqual(TEXT("Panel objects do not grow with the inventory"), panelObjects.Num(), firstPanelObjects);
+		}
+
+		//Scrolling past the end keeps the last page full
+		panel->SetScrollOffset(itemCount);
+		TestEqual(TEXT("Scroll offset clamps to the last page"), panel->GetScrollOffset(), FMath::Max(itemCount - panel->GetNumRowWidgets(), 0));
+
+		//Search results come back in the panel's sort order, not by name
+		panel->SetSort(EInventorySort::E_Weight);
+		panel->SetNameSearch(TEXT("Item 000"));
+		const FInventory& inventory = character->GetInventory();
+		const TArrayView<const int32> shown = panel->GetShownSlots();
+		TestTrue(TEXT("Search finds items"), shown.Num() > 0);
+		for (int32 i = 1; i < shown.Num(); i++)
+		{
+			if (!TestTrue(TEXT("Search results are sorted by weight"), inventory.GetItemData(shown[i - 1])->weight <= inventory.GetItemData(shown[i])->weight))
+			{
+				break;
+			}
+		}
+
+		panel->RemoveFromParent();
+	}
+
+	GEngine->DestroyWorldContext(world);
+	world->DestroyWorld(false);
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,252 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LootTable.h"
+#include "FirstRPG.h"
+#include "MyActor.h"
+
+//Backstop for nesting changed after the tables were compiled; Compile already refuses cycles
+static constexpr int MaxLootTableDepth = 8;
+
+//Depth-first walk over nested tables. Returns the table that closes a cycle, or null if there is none.
+static const ULootTable* FindNestedCycle(const ULootTable* _table, TArray<const ULootTable*, TInlineAllocator<8>>& _path, TSet<const ULootTable*>& _finished)
+{
+	if (_finished.Contains(_table))
+	{
+		return nullptr;
+	}
+	if (_path.Contains(_table))
+	{
+		return _table;
+	}
+
+	_path.Push(_table);
+	for (const FLootEntry& entry : _table->entries)
+	{
+		if (entry.nestedTable != nullptr)
+		{
+			if (const ULootTable* cycle = FindNestedCycle(entry.nestedTable, _path, _finished))
+			{
+				return cycle;
+			}
+		}
+	}
+	_path.Pop(false);
+	_finished.Add(_table);
+	return nullptr;
+}
+
+FLootEntry::FLootEntry()
+{
+	weight = 1.0f;
+	item = nullptr;
+	nestedTable = nullptr;
+	minQuantity = 1;
+	maxQuantity = 1;
+}
+
+ULootTable::ULootTable()
+{
+	numRolls = 1;
+	experience = 0.0f;
+}
+
+void ULootTable::PostLoad()
+{
+	Super::PostLoad();
+
+	Compile();
+}
+
+#if WITH_EDITOR
+void ULootTable::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	Compile();
+}
+#endif
+
+void ULootTable::Compile()
+{
+	LLM_SCOPE_BYTAG(FirstRPG_Items);
+
+	aliasProbability.Reset();
+	aliasIndex.Reset();
+
+	//A table that reaches itself again would fan out numRolls times per level, so it stays empty instead
+	TArray<const ULootTable*, TInlineAllocator<8>> path;
+	TSet<const ULootTable*> finished;
+	if (const ULootTable* cycle = FindNestedCycle(this, path, finished))
+	{
+		UE_LOG(LogFirstRPG, Warning, TEXT("Loot table '%s' reaches '%s' through its own nested tables and will never drop anything"), *GetPathName(), *cycle->GetPathName());
+		return;
+	}
+
+	const int numEntries = entries.Num();
+	float totalWeight = 0.0f;
+	for (const FLootEntry& entry : entries)
+	{
+		totalWeight += FMath::Max(0.0f, entry.weight);
+	}
+
+	if (numEntries == 0 || totalWeight <= 0.0f)
+	{
+		if (numEntries > 0)
+		{
+			UE_LOG(LogFirstRPG, Warning, TEXT("Loot table '%s' has no positive weights and will never drop anything"), *GetPathName());
+		}
+		return;
+	}
+
+	//Vose's alias method: scale weights so the average column is 1, then pair each
+	//under-full column with an over-full one until every column is exactly full
+	aliasProbability.SetNumUninitialized(numEntries);
+	aliasIndex.SetNumUninitialized(numEntries);
+
+	TArray<float> scaled;
+	scaled.SetNumUninitialized(numEntries);
+	TArray<int32> underFull;
+	TArray<int32> overFull;
+	underFull.Reserve(numEntries);
+	overFull.Reserve(numEntries);
+
+	for (int i = 0; i < numEntries; i++)
+	{
+		scaled[i] = FMath::Max(0.0f, entries[i].weight) * numEntries / totalWeight;
+		aliasIndex[i] = i;
+		if (scaled[i] < 1.0f)
+		{
+			underFull.Add(i);
+		}
+		else
+		{
+			overFull.Add(i);
+		}
+	}
+
+	while (underFull.Num() > 0 && overFull.Num() > 0)
+	{
+		const int32 less = underFull.Pop(false);
+		const int32 more = overFull.Last();
+
+		aliasProbability[less] = scaled[less];
+		aliasIndex[less] = more;
+
+		scaled[more] = (scaled[more] + scaled[less]) - 1.0f;
+		if (scaled[more] < 1.0f)
+		{
+			overFull.Pop(false);
+			underFull.Add(more);
+		}
+	}
+
+	//Whatever is left is full up to float rounding
+	for (int32 index : overFull)
+	{
+		aliasProbability[index] = 1.0f;
+	}
+	for (int32 index : underFull)
+	{
+		aliasProbability[index] = 1.0f;
+	}
+}
+
+void ULootTable::Roll(FRandomStream& _stream, TArray<FLootDrop>& _outDrops, float* _outExperience) const
+{
+	RollInternal(_stream, _outDrops, _outExperience, 0);
+}
+
+void ULootTable::RollInternal(FRandomStream& _stream, TArray<FLootDrop>& _outDrops, float* _outExperience, int _depth) const
+{
+	if (_depth >= MaxLootTableDepth)
+	{
+		return;
+	}
+
+	if (_outExperience != nullptr)
+	{
+		*_outExperience += experience;
+	}
+
+	const int numColumns = aliasIndex.Num();
+	if (numColumns == 0)
+	{
+		return;
+	}
+
+	for (int roll = 0; roll < numRolls; roll++)
+	{
+		const int column = _stream.RandHelper(numColumns);
+		const int picked = _stream.GetFraction() < aliasProbability[column] ? column : aliasIndex[column];
+		const FLootEntry& entry = entries[picked];
+
+		if (entry.nestedTable != nullptr)
+		{
+			entry.nestedTable->RollInternal(_stream, _outDrops, _outExperience, _depth + 1);
+		}
+		else if (entry.item != nullptr)
+		{
+			const int quantity = _stream.RandRange(entry.minQuantity, FMath::Max(entry.minQuantity, entry.maxQuantity));
+			if (quantity > 0)
+			{
+				FLootDrop& drop = _outDrops.AddDefaulted_GetRef();
+				drop.item = entry.item;
+				drop.quantity = quantity;
+			}
+		}
+	}
+}
+
+void ULootTable::RollBatch(TArrayView<const ULootTable* const> _tables, int32 _seed, TArray<FLootDrop>& _outDrops, float* _outExperience)
+{
+	FRandomStream stream;
+	for (int i = 0; i < _tables.Num(); i++)
+	{
+		if (_tables[i] != nullptr)
+		{
+			stream.Initialize((int32)HashCombine(GetTypeHash(_seed), GetTypeHash(i)));
+			_tables[i]->Roll(stream, _outDrops, _outExperience);
+		}
+	}
+}
+
+TArray<FLootDrop> ULootTable::RollLoot(int _seed) const
+{
+	TArray<FLootDrop> drops;
+	FRandomStream stream(_seed);
+	Roll(stream, drops);
+	return drops;
+}
+
+FLootBatchResult ULootTable::RollKillRewards(const TArray<AMyActor*>& _killed, int _seed)
+{
+	FLootBatchResult result;
+
+	TArray<const ULootTable*, TInlineAllocator<64>> tables;
+	tables.Reserve(_killed.Num());
+	for (const AMyActor* enemy : _killed)
+	{
+		tables.Add(enemy != nullptr ? enemy->lootTable : nullptr);
+	}
+
+	TArray<FLootDrop> rolled;
+	rolled.Reserve(tables.Num());
+	RollBatch(tables, _seed, rolled, &result.experience);
+
+	//Merge stacks so hundreds of kills collapse to one entry per item class
+	TMap<UClass*, int32> stackIndex;
+	for (const FLootDrop& drop : rolled)
+	{
+		if (int32* existing = stackIndex.Find(drop.item))
+		{
+			result.drops[*existing].quantity += drop.quantity;
+		}
+		else
+		{
+			stackIndex.Add(drop.item, result.drops.Add(drop));
+		}
+	}
+
+	return result;
+}
@@ -0,0 +1,126 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "DefaultItem.h"
+#include "LootTable.generated.h"
+
+class AMyActor;
+class ULootTable;
+
+/**
+ * Weighted loot table. Entries are compiled into an alias table when the asset loads,
+ * so every roll costs one random index and one random fraction no matter how many entries there are.
+ */
+
+USTRUCT(BlueprintType)
+struct FLootEntry
+{
+	GENERATED_BODY()
+
+public:
+	FLootEntry();
+
+	//Relative chance of this entry being picked
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float weight;
+
+	//Item dropped by this entry. Leave empty (with no nested table) for a "nothing" entry.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	TSubclassOf<ADefaultItem> item;
+
+	//Table rolled instead of item when set
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	ULootTable* nestedTable;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int minQuantity;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int maxQuantity;
+};
+
+//A rolled item stack, ready to go into an inventory without spawning an actor
+USTRUCT(BlueprintType)
+struct FLootDrop
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	TSubclassOf<ADefaultItem> item;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int quantity = 0;
+};
+
+//Everything a batch of kills dropped, merged per item class
+USTRUCT(BlueprintType)
+struct FLootBatchResult
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	TArray<FLootDrop> drops;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float experience = 0.0f;
+};
+
+UCLASS(BlueprintType)
+class FIRSTRPG_API ULootTable : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	ULootTable();
+
+	virtual void PostLoad() override;
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+	//Builds the alias table from entries. Tables created or edited at runtime must call this before rolling;
+	//rolls can run on worker threads, so they never compile on demand.
+	//A table whose nested entries lead back to a table already on the path is left empty, with one warning.
+	UFUNCTION(BlueprintCallable, Category = "Loot")
+	void Compile();
+
+	//Rolls the table numRolls times and appends the results. Pure data, so it is safe on worker threads.
+	//_outExperience, if given, gains this table's experience plus that of every nested table the roll reaches.
+	void Roll(FRandomStream& _stream, TArray<FLootDrop>& _outDrops, float* _outExperience = nullptr) const;
+
+	//Rolls one table per entry with a stream derived from _seed and the entry's index,
+	//so the same seed always gives the same drops. Null tables are skipped.
+	static void RollBatch(TArrayView<const ULootTable* const> _tables, int32 _seed, TArray<FLootDrop>& _outDrops, float* _outExperience = nullptr);
+
+	//Rolls this table once with a fixed seed
+	UFUNCTION(BlueprintCallable, Category = "Loot")
+	TArray<FLootDrop> RollLoot(int _seed) const;
+
+	//Resolves the rewards for a whole set of kills in one call, merging drops per item class
+	UFUNCTION(BlueprintCallable, Category = "Loot")
+	static FLootBatchResult RollKillRewards(const TArray<AMyActor*>& _killed, int _seed);
+
+	//Weighted entries designers edit
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Loot")
+	TArray<FLootEntry> entries;
+
+	//How many times the table is rolled per drop
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Loot")
+	int numRolls;
+
+	//Flat experience granted alongside the drops, each time this table is rolled or reached through a nested entry
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Loot")
+	float experience;
+
+private:
+	void RollInternal(FRandomStream& _stream, TArray<FLootDrop>& _outDrops, float* _outExperience, int _depth) const;
+
+	//Alias table: pick a column uniformly, keep it with aliasProbability, otherwise take aliasIndex
+	TArray<float> aliasProbability;
+	TArray<int32> aliasIndex;
+};
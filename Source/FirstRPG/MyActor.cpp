@@ -2,22 +2,82 @@
 
 
 #include "MyActor.h"
+#include "FirstRPG.h"
+#include "StreamingStateSubsystem.h"
+#include "EnemyUpdateSubsystem.h"
+#include "EnemyPathService.h"
+#include "GameplayTelemetry.h"
 
 // Sets default values
 AMyActor::AMyActor()
 {
+	LLM_SCOPE_BYTAG(FirstRPG_Enemies);
+
  	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = true;
 	health = 1.00f;
 	hasTakenDamage = false;
 	isDead = false;
+	lootTable = nullptr;
+	aggroRange = 1500.0f;
+	viewHalfAngle = 180.0f;
+	target = nullptr;
+	pendingDamage = 0.0f;
+	isUpdateRegistered = false;
 }
 
 // Called when the game starts or when spawned
 void AMyActor::BeginPlay()
 {
+	LLM_SCOPE_BYTAG(FirstRPG_Enemies);
+
+	//Coming back from an unloaded cell, restore before the Blueprint's BeginPlay sees the defaults
+	if (UStreamingStateSubsystem* streamingState = GetWorld()->GetSubsystem<UStreamingStateSubsystem>())
+	{
+		if (const FEnemyStreamingState* savedState = streamingState->FindEnemyState(this))
+		{
+			health = savedState->health;
+			isDead = savedState->isDead;
+		}
+	}
+
 	Super::BeginPlay();
-	
+
+	//Killed before its cell was unloaded; it stays dead rather than coming back at full health
+	if (isDead)
+	{
+		Destroy();
+		return;
+	}
+
+	if (UEnemyUpdateSubsystem* enemyUpdate = GetWorld()->GetSubsystem<UEnemyUpdateSubsystem>())
+	{
+		enemyUpdate->RegisterEnemy(this);
+	}
+}
+
+void AMyActor::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UEnemyUpdateSubsystem* enemyUpdate = GetWorld()->GetSubsystem<UEnemyUpdateSubsystem>())
+	{
+		enemyUpdate->UnregisterEnemy(this);
+	}
+
+	//A streaming unload, or a level-placed enemy destroying itself (e.g. on death): both are loaded again with the cell
+	if (EndPlayReason == EEndPlayReason::RemovedFromWorld
+		|| (EndPlayReason == EEndPlayReason::Destroyed && UStreamingStateSubsystem::IsStreamedActor(this)))
+	{
+		if (UStreamingStateSubsystem* streamingState = GetWorld()->GetSubsystem<UStreamingStateSubsystem>())
+		{
+			//Damage still waiting for the update phase counts, or it would be lost with the cell
+			FEnemyStreamingState state;
+			state.health = health - pendingDamage;
+			state.isDead = isDead || state.health <= 0.0f;
+			streamingState->StoreEnemyState(this, state);
+		}
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
 // Called every frame
@@ -29,11 +89,27 @@ void AMyActor::Tick(float DeltaTime)
 
 void AMyActor::TakeDamage(float _damage)
 {
+	//Registered enemies are resolved in a batch by the update phase. Each hit is still its own record,
+	//with the health it leaves once the phase applies everything pending.
+	if (UEnemyUpdateSubsystem::IsRegistered(this))
+	{
+		pendingDamage += _damage;
+		FGameplayTelemetry::Record(ETelemetryEvent::Damage, this, NAME_None, _damage, health - pendingDamage);
+		return;
+	}
+
+	//Anything the phase will not see again applies straight away
+	const bool wasDead = isDead;
 	health -= _damage;
+	FGameplayTelemetry::Record(ETelemetryEvent::Damage, this, NAME_None, _damage, health);
 
 	if (health <= 0.0f)
 	{
 		isDead = true;
+		if (!wasDead)
+		{
+			FGameplayTelemetry::Record(ETelemetryEvent::Kill, this, GetClass()->GetFName());
+		}
 	}
 	else
 	{
@@ -41,3 +117,10 @@ void AMyActor::TakeDamage(float _damage)
 	}
 }
 
+void AMyActor::RequestMoveTo(FVector _goal)
+{
+	if (UEnemyPathService* pathService = GetWorld()->GetSubsystem<UEnemyPathService>())
+	{
+		pathService->RequestPath(this, _goal);
+	}
+}
@@ -6,6 +6,10 @@
 #include "GameFramework/Character.h"
 #include "MyActor.generated.h"
 
+class ULootTable;
+class AFirstRPGCharacter;
+class UEnemyUpdateSubsystem;
+
 UCLASS()
 class FIRSTRPG_API AMyActor : public ACharacter
 {
@@ -15,13 +19,29 @@ public:
 	// Sets default values for this actor's properties
 	AMyActor();
 
+	//Taking Damage. While the enemy update phase runs this enemy, the damage is queued and health, isDead and
+	//hasTakenDamage only change in the next phase, up to a frame later but before this enemy ticks.
+	//Otherwise (before BeginPlay, after EndPlay, worlds without the phase) it applies straight away.
+	UFUNCTION(BlueprintCallable)
+	void TakeDamage(float _damageAmount);
+
+	//Moves toward _goal on a path from the shared path service rather than a query of its own. Needs an AI controller.
+	UFUNCTION(BlueprintCallable, Category = Enemy)
+	void RequestMoveTo(FVector _goal);
+
+	bool IsDead() const { return isDead; }
+	AFirstRPGCharacter* GetTarget() const { return target; }
+
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
-	//Taking Damage
-	UFUNCTION(BlueprintCallable)
-	void TakeDamage(float _damageAmount);
+	// Called when the actor is destroyed or its level streams out
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	//Called once when health runs out, after the update phase has written every enemy
+	UFUNCTION(BlueprintImplementableEvent, Category = Enemy)
+	void OnDeath();
 
 	//Current Health of enemy
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Enemy)
@@ -34,8 +54,34 @@ protected:
 	//Death
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Enemy)
 	bool isDead;
+
+	//How close a player has to be before this enemy targets them
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Enemy)
+	float aggroRange;
+
+	//Half angle of the view cone in degrees, measured from the actor's forward; 180 sees all the way round
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Enemy, meta = (ClampMin = "0", ClampMax = "180"))
+	float viewHalfAngle;
+
+	//Player this enemy is after, set by the update phase; null when nobody is in range and in view
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Transient, Category = Enemy)
+	AFirstRPGCharacter* target;
+
+private:
+	friend class UEnemyUpdateSubsystem;
+
+	//Damage taken since the last update phase
+	float pendingDamage;
+
+	//Set by UEnemyUpdateSubsystem while this enemy is in its phase
+	bool isUpdateRegistered;
+
 public:	
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
 
+	//What this enemy drops when killed
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Enemy)
+	ULootTable* lootTable;
+
 };
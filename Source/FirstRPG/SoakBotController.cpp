@@ -0,0 +1,168 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SoakBotController.h"
+#include "FirstRPG.h"
+#include "FirstRPGCharacter.h"
+#include "DefaultItem.h"
+#include "BaseQuest.h"
+#include "MyActor.h"
+#include "Engine/OverlapResult.h"
+#include "NavigationSystem.h"
+#include "TimerManager.h"
+
+ASoakBotController::ASoakBotController()
+{
+	actionInterval = 2.0f;
+	wanderRadius = 2000.0f;
+	punchRange = 200.0f;
+	maxHeldItems = 20;
+	quest = nullptr;
+}
+
+void ASoakBotController::OnPossess(APawn* InPawn)
+{
+	Super::OnPossess(InPawn);
+
+	//Stagger bots so they do not all act on the same frame
+	GetWorldTimerManager().SetTimer(actionTimer, this, &ASoakBotController::TakeAction, actionInterval, true, random.FRandRange(0.0f, actionInterval));
+}
+
+void ASoakBotController::OnUnPossess()
+{
+	GetWorldTimerManager().ClearTimer(actionTimer);
+
+	Super::OnUnPossess();
+}
+
+void ASoakBotController::TakeAction()
+{
+	AFirstRPGCharacter* bot = Cast<AFirstRPGCharacter>(GetPawn());
+	if (bot == nullptr)
+	{
+		return;
+	}
+
+	switch (random.RandRange(0, 4))
+	{
+	case 0:
+		Wander(bot);
+		break;
+	case 1:
+		PunchNearbyEnemy(bot);
+		break;
+	case 2:
+		PickUpItem(bot);
+		break;
+	case 3:
+		TakeHits(bot);
+		break;
+	default:
+		WorkOnQuest(bot);
+		break;
+	}
+}
+
+void ASoakBotController::Wander(AFirstRPGCharacter* _bot)
+{
+	const FVector origin = _bot->GetActorLocation();
+
+	//Walk the navmesh when the map has one, otherwise head straight for a point on the same level
+	if (UNavigationSystemV1* navSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld()))
+	{
+		FNavLocation destination;
+		if (navSystem->GetRandomReachablePointInRadius(origin, wanderRadius, destination))
+		{
+			MoveToLocation(destination.Location);
+			return;
+		}
+	}
+
+	const FVector2D offset = FVector2D(random.FRandRange(-1.0f, 1.0f), random.FRandRange(-1.0f, 1.0f)).GetSafeNormal() * random.FRandRange(0.0f, wanderRadius);
+	MoveToLocation(origin + FVector(offset, 0.0f), -1.0f, true, false);
+}
+
+void ASoakBotController::PickUpItem(AFirstRPGCharacter* _bot)
+{
+	//Dropped items are destroyed, so item actors should come and go without piling up
+	if (heldItems.Num() >= maxHeldItems)
+	{
+		ADefaultItem* oldest = heldItems[0];
+		heldItems.RemoveAt(0);
+		if (oldest != nullptr)
+		{
+			_bot->RemoveFromInventory(oldest);
+			oldest->Destroy();
+		}
+	}
+
+	FActorSpawnParameters spawnParameters;
+	spawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	ADefaultItem* item = GetWorld()->SpawnActor<ADefaultItem>(ADefaultItem::StaticClass(), _bot->GetActorTransform(), spawnParameters);
+	if (item != nullptr)
+	{
+		item->SetActorHiddenInGame(true);
+		item->SetActorEnableCollision(false);
+		_bot->AddToInventory(item);
+		heldItems.Add(item);
+	}
+}
+
+void ASoakBotController::TakeHits(AFirstRPGCharacter* _bot)
+{
+	//Always heal back what was taken so bots never die and stop acting
+	const float damage = random.FRandRange(0.05f, 0.3f);
+	_bot->TakeDamage(damage);
+	_bot->HealArmor(damage * 0.5f);
+	_bot->Heal(damage);
+}
+
+void ASoakBotController::PunchNearbyEnemy(AFirstRPGCharacter* _bot)
+{
+	_bot->Punch();
+
+	//The same damage a player's punch deals, through the damage formula and the enemy update phase
+	TArray<FOverlapResult> overlaps;
+	const FCollisionQueryParams queryParams(SCENE_QUERY_STAT(SoakBotPunch), false, _bot);
+	GetWorld()->OverlapMultiByObjectType(overlaps, _bot->GetActorLocation(), FQuat::Identity,
+		FCollisionObjectQueryParams(FCollisionObjectQueryParams::AllDynamicObjects), FCollisionShape::MakeSphere(punchRange), queryParams);
+
+	AMyActor* nearest = nullptr;
+	double nearestDistanceSquared = TNumericLimits<double>::Max();
+	for (const FOverlapResult& overlap : overlaps)
+	{
+		AMyActor* enemy = Cast<AMyActor>(overlap.GetActor());
+		const double distanceSquared = enemy != nullptr ? FVector::DistSquared(enemy->GetActorLocation(), _bot->GetActorLocation()) : 0.0;
+		if (enemy != nullptr && distanceSquared < nearestDistanceSquared)
+		{
+			nearest = enemy;
+			nearestDistanceSquared = distanceSquared;
+		}
+	}
+
+	if (nearest != nullptr)
+	{
+		nearest->TakeDamage(_bot->ComputeHitDamage());
+	}
+}
+
+void ASoakBotController::WorkOnQuest(AFirstRPGCharacter* _bot)
+{
+	if (quest == nullptr)
+	{
+		quest = NewObject<UBaseQuest>(this);
+		quest->questId = TEXT("SoakQuest");
+		quest->SetNumObjectives(1);
+		quest->SetUpObjective(0, nullptr, ADefaultItem::StaticClass(), FText::GetEmpty(), random.RandRange(1, 5));
+
+		//Enough that bots level up every few quests, so the level-up path is soaked too
+		quest->reward.experience = random.FRandRange(100.0f, 400.0f);
+	}
+
+	//A finished quest is dropped for the garbage collector and a new one made next time
+	if (quest->AdvanceObjective(0))
+	{
+		_bot->GainExperience(quest->reward.experience);
+		quest = nullptr;
+	}
+}
@@ -0,0 +1,69 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AIController.h"
+#include "SoakBotController.generated.h"
+
+class AFirstRPGCharacter;
+class ADefaultItem;
+class UBaseQuest;
+
+/**
+ * Drives an AFirstRPGCharacter during a soak test. Every few seconds it picks a random action:
+ * walk somewhere, punch, pick up and later drop an item, take damage and heal, or make progress on
+ * a quest. The point is steady churn through the same code paths players hit, so anything that
+ * grows without bound shows up over a long run.
+ */
+UCLASS()
+class FIRSTRPG_API ASoakBotController : public AAIController
+{
+	GENERATED_BODY()
+
+public:
+	ASoakBotController();
+
+	//Seeds the bot's choices so a failing run can be repeated
+	void SetSeed(int32 _seed) { random.Initialize(_seed); }
+
+protected:
+	virtual void OnPossess(APawn* InPawn) override;
+	virtual void OnUnPossess() override;
+
+	void TakeAction();
+
+	void Wander(AFirstRPGCharacter* _bot);
+	void PickUpItem(AFirstRPGCharacter* _bot);
+	void TakeHits(AFirstRPGCharacter* _bot);
+	void PunchNearbyEnemy(AFirstRPGCharacter* _bot);
+	void WorkOnQuest(AFirstRPGCharacter* _bot);
+
+	//Seconds between actions
+	UPROPERTY(EditAnywhere, Category = "Soak")
+	float actionInterval;
+
+	//How far from where it stands a bot will wander
+	UPROPERTY(EditAnywhere, Category = "Soak")
+	float wanderRadius;
+
+	//How close an enemy has to be for a punch to land
+	UPROPERTY(EditAnywhere, Category = "Soak")
+	float punchRange;
+
+	//Items a bot holds before it starts dropping the oldest
+	UPROPERTY(EditAnywhere, Category = "Soak")
+	int maxHeldItems;
+
+private:
+	//Picked-up items, oldest first
+	UPROPERTY()
+	TArray<ADefaultItem*> heldItems;
+
+	//Replaced with a fresh quest each time one is finished
+	UPROPERTY()
+	UBaseQuest* quest;
+
+	FRandomStream random;
+	FTimerHandle actionTimer;
+};
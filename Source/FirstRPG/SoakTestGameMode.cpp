@@ -0,0 +1,387 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SoakTestGameMode.h"
+#include "FirstRPG.h"
+#include "FirstRPGCharacter.h"
+#include "FirstRPGMemoryReport.h"
+#include "LootTable.h"
+#include "MyActor.h"
+#include "SoakBotController.h"
+#include "HAL/PlatformMemory.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "TimerManager.h"
+#include "UObject/UObjectArray.h"
+
+CSV_DEFINE_CATEGORY(FirstRPGSoak, true);
+
+//Growth across the samples from a least-squares line, so one noisy sample cannot pass or fail the run.
+//Returns the growth from the first to the last sample time, and the fitted value at the first.
+template <typename GetterType>
+static float FitGrowth(TArrayView<const FSoakSample> _samples, GetterType _getValue, float& _outStartValue)
+{
+	const int32 count = _samples.Num();
+	double meanTime = 0.0;
+	double meanValue = 0.0;
+	for (const FSoakSample& sample : _samples)
+	{
+		meanTime += sample.elapsedSeconds;
+		meanValue += _getValue(sample);
+	}
+	meanTime /= count;
+	meanValue /= count;
+
+	double covariance = 0.0;
+	double variance = 0.0;
+	for (const FSoakSample& sample : _samples)
+	{
+		covariance += (sample.elapsedSeconds - meanTime) * (_getValue(sample) - meanValue);
+		variance += FMath::Square(sample.elapsedSeconds - meanTime);
+	}
+
+	const double slope = variance > 0.0 ? covariance / variance : 0.0;
+	const double startTime = _samples[0].elapsedSeconds;
+	_outStartValue = (float)(meanValue + slope * (startTime - meanTime));
+	return (float)(slope * (_samples.Last().elapsedSeconds - startTime));
+}
+
+ASoakTestGameMode::ASoakTestGameMode()
+{
+	PrimaryActorTick.bCanEverTick = true;
+
+	durationMinutes = 60.0f;
+	numBots = 8;
+	numEnemies = 32;
+	enemyClass = AMyActor::StaticClass();
+	enemySpawnRadius = 800.0f;
+	enemyRecycleSeconds = 2.0f;
+	sampleIntervalSeconds = 60.0f;
+	warmupMinutes = 5.0f;
+	seed = 1;
+	maxObjectGrowthPercent = 5.0f;
+	maxMemoryGrowthMB = 64.0f;
+	maxFrameTimeGrowthPercent = 20.0f;
+}
+
+void ASoakTestGameMode::InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage)
+{
+	Super::InitGame(MapName, Options, ErrorMessage);
+
+	const TCHAR* commandLine = FCommandLine::Get();
+	FParse::Value(commandLine, TEXT("SoakMinutes="), durationMinutes);
+	FParse::Value(commandLine, TEXT("SoakBots="), numBots);
+	FParse::Value(commandLine, TEXT("SoakEnemies="), numEnemies);
+	FParse::Value(commandLine, TEXT("SoakSampleSeconds="), sampleIntervalSeconds);
+	FParse::Value(commandLine, TEXT("SoakWarmupMinutes="), warmupMinutes);
+	FParse::Value(commandLine, TEXT("SoakSeed="), seed);
+	FParse::Value(commandLine, TEXT("SoakMaxObjectGrowthPercent="), maxObjectGrowthPercent);
+	FParse::Value(commandLine, TEXT("SoakMaxMemoryGrowthMB="), maxMemoryGrowthMB);
+	FParse::Value(commandLine, TEXT("SoakMaxFrameTimeGrowthPercent="), maxFrameTimeGrowthPercent);
+
+	sampleIntervalSeconds = FMath::Max(1.0f, sampleIntervalSeconds);
+	random.Initialize(seed);
+}
+
+void ASoakTestGameMode::StartPlay()
+{
+	Super::StartPlay();
+
+	UE_LOG(LogFirstRPG, Display, TEXT("Soak test: %d bots and %d enemies for %.1f minutes, sampling every %.0f s after a %.1f minute warmup (seed %d)"),
+		numBots, numEnemies, durationMinutes, sampleIntervalSeconds, warmupMinutes, seed);
+
+#if CSV_PROFILER
+	//Per-frame stats for the whole run, alongside the coarse samples taken here
+	if (!FCsvProfiler::Get()->IsCapturing())
+	{
+		FCsvProfiler::Get()->BeginCapture();
+	}
+#endif
+
+	SpawnBots();
+	for (int32 i = 0; i < numEnemies; i++)
+	{
+		SpawnEnemy();
+	}
+
+	//Timers run off world time, which keeps going without a viewport under -nullrhi
+	runStartTime = FPlatformTime::Seconds();
+	GetWorldTimerManager().SetTimer(sampleTimer, this, &ASoakTestGameMode::TakeSample, sampleIntervalSeconds, true);
+	GetWorldTimerManager().SetTimer(finishTimer, this, &ASoakTestGameMode::FinishRun, FMath::Max(1.0f, durationMinutes * 60.0f), false);
+	GetWorldTimerManager().SetTimer(enemyTimer, this, &ASoakTestGameMode::RecycleEnemies, FMath::Max(0.1f, enemyRecycleSeconds), true);
+}
+
+void ASoakTestGameMode::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	//DeltaSeconds is clamped, dilated and includes waiting on the frame-rate cap, so it can hide game thread cost
+	//creeping up. GGameThreadTime is the game thread's own work for the last frame.
+	const float gameThreadMs = FPlatformTime::ToMilliseconds(GGameThreadTime);
+	frameTimeSum += gameThreadMs;
+	frameTimeMax = FMath::Max(frameTimeMax, gameThreadMs);
+	numFrames++;
+}
+
+void ASoakTestGameMode::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	GetWorldTimerManager().ClearTimer(sampleTimer);
+	GetWorldTimerManager().ClearTimer(finishTimer);
+	GetWorldTimerManager().ClearTimer(enemyTimer);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ASoakTestGameMode::SpawnBots()
+{
+	UClass* botClass = DefaultPawnClass != nullptr && DefaultPawnClass->IsChildOf<AFirstRPGCharacter>() ? DefaultPawnClass.Get() : AFirstRPGCharacter::StaticClass();
+
+	const AActor* playerStart = FindPlayerStart(nullptr);
+	const FVector center = playerStart != nullptr ? playerStart->GetActorLocation() : FVector::ZeroVector;
+
+	FActorSpawnParameters spawnParameters;
+	spawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+	for (int32 i = 0; i < numBots; i++)
+	{
+		//In a ring round the start so they do not spawn inside each other
+		const float angle = 2.0f * PI * i / FMath::Max(1, numBots);
+		const FVector location = center + FVector(FMath::Cos(angle), FMath::Sin(angle), 0.0f) * 300.0f;
+
+		AFirstRPGCharacter* bot = GetWorld()->SpawnActor<AFirstRPGCharacter>(botClass, location, FRotator::ZeroRotator, spawnParameters);
+		ASoakBotController* controller = GetWorld()->SpawnActor<ASoakBotController>(spawnParameters);
+		if (bot == nullptr || controller == nullptr)
+		{
+			UE_LOG(LogFirstRPG, Warning, TEXT("Soak test: could not spawn bot %d"), i);
+			continue;
+		}
+
+		controller->SetSeed(seed + i);
+		controller->Possess(bot);
+		bots.Add(bot);
+	}
+}
+
+void ASoakTestGameMode::SpawnEnemy()
+{
+	if (bots.Num() == 0 || enemyClass == nullptr)
+	{
+		return;
+	}
+
+	//Close to a bot, so enemies spot it straight away and punches have something to land on
+	const AFirstRPGCharacter* bot = bots[random.RandHelper(bots.Num())];
+	if (!IsValid(bot))
+	{
+		return;
+	}
+	const FVector2D offset = FVector2D(random.FRandRange(-1.0f, 1.0f), random.FRandRange(-1.0f, 1.0f)).GetSafeNormal() * random.FRandRange(200.0f, enemySpawnRadius);
+	const FVector location = bot->GetActorLocation() + FVector(offset, 0.0f);
+
+	FActorSpawnParameters spawnParameters;
+	spawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+	AMyActor* enemy = GetWorld()->SpawnActor<AMyActor>(enemyClass, location, FRotator(0.0f, random.FRandRange(0.0f, 360.0f), 0.0f), spawnParameters);
+	if (enemy == nullptr)
+	{
+		UE_LOG(LogFirstRPG, Warning, TEXT("Soak test: could not spawn an enemy"));
+		return;
+	}
+
+	//Spawned pawns are not possessed automatically, and RequestMoveTo needs an AI controller
+	if (enemy->GetController() == nullptr)
+	{
+		enemy->SpawnDefaultController();
+	}
+	enemies.Add(enemy);
+}
+
+void ASoakTestGameMode::RecycleEnemies()
+{
+	TArray<AMyActor*> killed;
+	for (int32 i = enemies.Num() - 1; i >= 0; i--)
+	{
+		AMyActor* enemy = enemies[i];
+		if (!IsValid(enemy))
+		{
+			enemies.RemoveAtSwap(i);
+		}
+		else if (enemy->IsDead())
+		{
+			killed.Add(enemy);
+			enemies.RemoveAtSwap(i);
+		}
+	}
+
+	//Loot goes to whichever bot is nearest, the likeliest to have landed the last punch
+	for (AMyActor* enemy : killed)
+	{
+		AFirstRPGCharacter* looter = nullptr;
+		double nearestDistanceSquared = TNumericLimits<double>::Max();
+		for (AFirstRPGCharacter* bot : bots)
+		{
+			const double distanceSquared = IsValid(bot) ? FVector::DistSquared(bot->GetActorLocation(), enemy->GetActorLocation()) : TNumericLimits<double>::Max();
+			if (distanceSquared < nearestDistanceSquared)
+			{
+				looter = bot;
+				nearestDistanceSquared = distanceSquared;
+			}
+		}
+
+		if (looter != nullptr)
+		{
+			const FLootBatchResult rewards = ULootTable::RollKillRewards({ enemy }, random.RandHelper(MAX_int32));
+			looter->AddLootToInventory(rewards.drops);
+			looter->GainExperience(rewards.experience);
+		}
+		enemy->Destroy();
+	}
+
+	while (enemies.Num() < numEnemies && bots.Num() > 0)
+	{
+		const int32 numBefore = enemies.Num();
+		SpawnEnemy();
+		if (enemies.Num() == numBefore)
+		{
+			break;
+		}
+	}
+
+	//Enemies with a target chase it, the rest head for a random bot; either way through the shared path service
+	for (AMyActor* enemy : enemies)
+	{
+		const AFirstRPGCharacter* goal = enemy->GetTarget();
+		if (goal == nullptr && bots.Num() > 0)
+		{
+			goal = bots[random.RandHelper(bots.Num())];
+		}
+		if (IsValid(goal))
+		{
+			enemy->RequestMoveTo(goal->GetActorLocation());
+		}
+	}
+}
+
+void ASoakTestGameMode::TakeSample()
+{
+	//Count after a full collection, otherwise garbage waiting for the next GC looks like a leak
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS, true);
+
+	FSoakSample& sample = samples.AddDefaulted_GetRef();
+	sample.elapsedSeconds = (float)(FPlatformTime::Seconds() - runStartTime);
+	sample.averageFrameMs = numFrames > 0 ? (float)(frameTimeSum / numFrames) : 0.0f;
+	sample.maxFrameMs = frameTimeMax;
+	sample.uobjectCount = GUObjectArray.GetObjectArrayNumMinusAvailable();
+	sample.usedPhysicalMB = FPlatformMemory::GetStats().UsedPhysical / (1024.0f * 1024.0f);
+	for (const FSubsystemMemoryEntry& entry : UFirstRPGMemoryReport::GatherMemoryReport())
+	{
+		sample.firstRPGObjectCount += entry.objectCount;
+	}
+
+	frameTimeSum = 0.0;
+	frameTimeMax = 0.0f;
+	numFrames = 0;
+
+	CSV_CUSTOM_STAT(FirstRPGSoak, UObjects, sample.uobjectCount, ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(FirstRPGSoak, FirstRPGObjects, sample.firstRPGObjectCount, ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(FirstRPGSoak, UsedPhysicalMB, sample.usedPhysicalMB, ECsvCustomStatOp::Set);
+	CSV_EVENT(FirstRPGSoak, TEXT("Sample %d"), samples.Num());
+
+	UE_LOG(LogFirstRPG, Display, TEXT("Soak sample %d at %.0f s: game thread %.2f ms (max %.2f), %d UObjects, %d FirstRPG objects, %.1f MB used"),
+		samples.Num(), sample.elapsedSeconds, sample.averageFrameMs, sample.maxFrameMs, sample.uobjectCount, sample.firstRPGObjectCount, sample.usedPhysicalMB);
+}
+
+void ASoakTestGameMode::FinishRun()
+{
+	if (finished)
+	{
+		return;
+	}
+	finished = true;
+
+	TakeSample();
+	GetWorldTimerManager().ClearTimer(sampleTimer);
+
+#if CSV_PROFILER
+	FCsvProfiler::Get()->EndCapture();
+#endif
+
+	WriteSamples();
+
+	TArray<FString> failures;
+	const bool passed = EvaluateSamples(failures);
+	for (const FString& failure : failures)
+	{
+		UE_LOG(LogFirstRPG, Error, TEXT("Soak test: %s"), *failure);
+	}
+	UE_LOG(LogFirstRPG, Display, TEXT("SOAK TEST %s after %d samples"), passed ? TEXT("PASSED") : TEXT("FAILED"), samples.Num());
+
+	FPlatformMisc::RequestExitWithStatus(false, passed ? 0 : 1);
+}
+
+bool ASoakTestGameMode::EvaluateSamples(TArray<FString>& _outFailures) const
+{
+	const float warmupSeconds = warmupMinutes * 60.0f;
+	const int32 firstMeasured = samples.IndexOfByPredicate([warmupSeconds](const FSoakSample& _sample) { return _sample.elapsedSeconds >= warmupSeconds; });
+	const int32 numMeasured = firstMeasured != INDEX_NONE ? samples.Num() - firstMeasured : 0;
+
+	//A trend needs a few points; a run too short to judge is a failed run, not a pass
+	if (numMeasured < 3)
+	{
+		_outFailures.Add(FString::Printf(TEXT("only %d samples after warmup, need at least 3; lengthen -SoakMinutes or shorten -SoakSampleSeconds"), numMeasured));
+		return false;
+	}
+
+	const TArrayView<const FSoakSample> measured = MakeArrayView(samples).Slice(firstMeasured, numMeasured);
+
+	float startObjects = 0.0f;
+	const float objectGrowth = FitGrowth(measured, [](const FSoakSample& _sample) { return (double)_sample.uobjectCount; }, startObjects);
+	const float objectGrowthPercent = startObjects > 0.0f ? objectGrowth / startObjects * 100.0f : 0.0f;
+	if (objectGrowthPercent > maxObjectGrowthPercent)
+	{
+		_outFailures.Add(FString::Printf(TEXT("UObject count grew %.1f%% (%.0f objects), limit %.1f%%"), objectGrowthPercent, objectGrowth, maxObjectGrowthPercent));
+	}
+
+	float startGameObjects = 0.0f;
+	const float gameObjectGrowth = FitGrowth(measured, [](const FSoakSample& _sample) { return (double)_sample.firstRPGObjectCount; }, startGameObjects);
+	const float gameObjectGrowthPercent = startGameObjects > 0.0f ? gameObjectGrowth / startGameObjects * 100.0f : 0.0f;
+	if (gameObjectGrowthPercent > maxObjectGrowthPercent)
+	{
+		_outFailures.Add(FString::Printf(TEXT("FirstRPG object count grew %.1f%% (%.0f objects), limit %.1f%%"), gameObjectGrowthPercent, gameObjectGrowth, maxObjectGrowthPercent));
+	}
+
+	float startMemory = 0.0f;
+	const float memoryGrowth = FitGrowth(measured, [](const FSoakSample& _sample) { return (double)_sample.usedPhysicalMB; }, startMemory);
+	if (memoryGrowth > maxMemoryGrowthMB)
+	{
+		_outFailures.Add(FString::Printf(TEXT("used memory grew %.1f MB (from %.1f MB), limit %.1f MB"), memoryGrowth, startMemory, maxMemoryGrowthMB));
+	}
+
+	float startFrameMs = 0.0f;
+	const float frameGrowth = FitGrowth(measured, [](const FSoakSample& _sample) { return (double)_sample.averageFrameMs; }, startFrameMs);
+	const float frameGrowthPercent = startFrameMs > 0.0f ? frameGrowth / startFrameMs * 100.0f : 0.0f;
+	if (frameGrowthPercent > maxFrameTimeGrowthPercent)
+	{
+		_outFailures.Add(FString::Printf(TEXT("average game thread time drifted up %.1f%% (%.2f ms to %.2f ms), limit %.1f%%"), frameGrowthPercent, startFrameMs, startFrameMs + frameGrowth, maxFrameTimeGrowthPercent));
+	}
+
+	return _outFailures.Num() == 0;
+}
+
+void ASoakTestGameMode::WriteSamples() const
+{
+	TArray<FString> lines;
+	lines.Add(TEXT("Seconds,AverageFrameMs,MaxFrameMs,UObjects,FirstRPGObjects,UsedPhysicalMB"));
+	for (const FSoakSample& sample : samples)
+	{
+		lines.Add(FString::Printf(TEXT("%.1f,%.3f,%.3f,%d,%d,%.1f"), sample.elapsedSeconds, sample.averageFrameMs, sample.maxFrameMs,
+			sample.uobjectCount, sample.firstRPGObjectCount, sample.usedPhysicalMB));
+	}
+
+	const FString path = FPaths::ProjectSavedDir() / TEXT("Soak") / FString::Printf(TEXT("Soak_%s.csv"), *FDateTime::Now().ToString(TEXT("%Y%m%d-%H%M%S")));
+	if (FFileHelper::SaveStringArrayToFile(lines, *path))
+	{
+		UE_LOG(LogFirstRPG, Display, TEXT("Soak samples written to %s"), *path);
+	}
+}
@@ -0,0 +1,144 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FirstRPGGameMode.h"
+#include "SoakTestGameMode.generated.h"
+
+class AFirstRPGCharacter;
+class AMyActor;
+
+/**
+ * Unattended soak test. Spawns scripted bot characters and enemies for them to fight, records CSV profiler frame stats, and
+ * samples frame time, UObject counts and memory at fixed intervals. At the end it checks the
+ * samples for steady growth and exits with 0 on a pass and 1 on a fail. On a headless Linux box:
+ *
+ *     FirstRPG ThirdPersonMap?game=Soak -nullrhi -nosound -unattended -SoakMinutes=240
+ *
+ * Enemies chase the bots through the path service and the enemy update phase. Killed ones are looted into the
+ * nearest bot's inventory, destroyed and replaced, so the enemy count stays steady while actors churn.
+ *
+ * Options: -SoakMinutes= -SoakBots= -SoakEnemies= -SoakSampleSeconds= -SoakWarmupMinutes= -SoakSeed=
+ *          -SoakMaxObjectGrowthPercent= -SoakMaxMemoryGrowthMB= -SoakMaxFrameTimeGrowthPercent=
+ */
+
+//One sample taken during the run
+USTRUCT()
+struct FSoakSample
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY()
+	float elapsedSeconds = 0.0f;
+
+	//Average and worst game thread time per frame since the last sample, idle and frame-rate cap excluded
+	UPROPERTY()
+	float averageFrameMs = 0.0f;
+
+	UPROPERTY()
+	float maxFrameMs = 0.0f;
+
+	//Counted after a full garbage collection so only live objects show
+	UPROPERTY()
+	int uobjectCount = 0;
+
+	UPROPERTY()
+	int firstRPGObjectCount = 0;
+
+	UPROPERTY()
+	float usedPhysicalMB = 0.0f;
+};
+
+UCLASS()
+class FIRSTRPG_API ASoakTestGameMode : public AFirstRPGGameMode
+{
+	GENERATED_BODY()
+
+public:
+	ASoakTestGameMode();
+
+	virtual void InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage) override;
+	virtual void StartPlay() override;
+	virtual void Tick(float DeltaSeconds) override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+protected:
+	void SpawnBots();
+	void SpawnEnemy();
+
+	//Replaces dead enemies after looting them, and sends the rest after the bots
+	void RecycleEnemies();
+	void TakeSample();
+	void FinishRun();
+
+	//Compares the post-warmup samples against the thresholds; returns false and fills _outFailures on growth
+	bool EvaluateSamples(TArray<FString>& _outFailures) const;
+	void WriteSamples() const;
+
+	UPROPERTY(EditAnywhere, Category = "Soak")
+	float durationMinutes;
+
+	UPROPERTY(EditAnywhere, Category = "Soak")
+	int numBots;
+
+	//Enemies kept alive around the bots
+	UPROPERTY(EditAnywhere, Category = "Soak")
+	int numEnemies;
+
+	UPROPERTY(EditAnywhere, Category = "Soak")
+	TSubclassOf<AMyActor> enemyClass;
+
+	//How far from a bot enemies appear
+	UPROPERTY(EditAnywhere, Category = "Soak")
+	float enemySpawnRadius;
+
+	//Seconds between replacing dead enemies and sending the rest after the bots
+	UPROPERTY(EditAnywhere, Category = "Soak")
+	float enemyRecycleSeconds;
+
+	UPROPERTY(EditAnywhere, Category = "Soak")
+	float sampleIntervalSeconds;
+
+	//Samples before this are left out of the growth checks while caches and pools fill up
+	UPROPERTY(EditAnywhere, Category = "Soak")
+	float warmupMinutes;
+
+	UPROPERTY(EditAnywhere, Category = "Soak")
+	int seed;
+
+	//Allowed growth over the measured part of the run, projected from the trend of the samples
+	UPROPERTY(EditAnywhere, Category = "Soak")
+	float maxObjectGrowthPercent;
+
+	UPROPERTY(EditAnywhere, Category = "Soak")
+	float maxMemoryGrowthMB;
+
+	UPROPERTY(EditAnywhere, Category = "Soak")
+	float maxFrameTimeGrowthPercent;
+
+private:
+	UPROPERTY()
+	TArray<FSoakSample> samples;
+
+	UPROPERTY()
+	TArray<AFirstRPGCharacter*> bots;
+
+	UPROPERTY()
+	TArray<AMyActor*> enemies;
+
+	//For enemy placement and loot rolls, from the run's seed
+	FRandomStream random;
+
+	double runStartTime = 0.0;
+	//Game thread milliseconds
+	double frameTimeSum = 0.0;
+	float frameTimeMax = 0.0f;
+	int32 numFrames = 0;
+	bool finished = false;
+
+	FTimerHandle sampleTimer;
+	FTimerHandle finishTimer;
+	FTimerHandle enemyTimer;
+};
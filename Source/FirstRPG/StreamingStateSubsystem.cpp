@@ -0,0 +1,83 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "StreamingStateSubsystem.h"
+#include "FirstRPG.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+
+CSV_DEFINE_CATEGORY(FirstRPGStreaming, true);
+
+void UStreamingStateSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	levelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &UStreamingStateSubsystem::OnLevelAdded);
+	levelRemovedHandle = FWorldDelegates::LevelRemovedFromWorld.AddUObject(this, &UStreamingStateSubsystem::OnLevelRemoved);
+}
+
+void UStreamingStateSubsystem::Deinitialize()
+{
+	FWorldDelegates::LevelAddedToWorld.Remove(levelAddedHandle);
+	FWorldDelegates::LevelRemovedFromWorld.Remove(levelRemovedHandle);
+
+	Super::Deinitialize();
+}
+
+bool UStreamingStateSubsystem::IsStreamedActor(const AActor* _actor)
+{
+	return _actor != nullptr && _actor->HasAnyFlags(RF_WasLoaded);
+}
+
+void UStreamingStateSubsystem::StoreEnemyState(const AActor* _enemy, const FEnemyStreamingState& _state)
+{
+	if (IsStreamedActor(_enemy))
+	{
+		enemyStates.Add(_enemy->GetFName(), _state);
+	}
+}
+
+const FEnemyStreamingState* UStreamingStateSubsystem::FindEnemyState(const AActor* _enemy) const
+{
+	return IsStreamedActor(_enemy) ? enemyStates.Find(_enemy->GetFName()) : nullptr;
+}
+
+void UStreamingStateSubsystem::MarkCollected(AActor* _pickup)
+{
+	if (IsStreamedActor(_pickup))
+	{
+		collectedPickups.Add(_pickup->GetFName());
+	}
+}
+
+bool UStreamingStateSubsystem::WasCollected(AActor* _pickup) const
+{
+	return IsStreamedActor(_pickup) && collectedPickups.Contains(_pickup->GetFName());
+}
+
+void UStreamingStateSubsystem::OnLevelAdded(ULevel* _level, UWorld* _world)
+{
+	if (_world != GetWorld())
+	{
+		return;
+	}
+
+	//Cell loads show up as events in CSV captures, so load hitches can be lined up against them
+	numLoadedCells++;
+	CSV_EVENT(FirstRPGStreaming, TEXT("CellLoaded %s"), *GetNameSafe(_level != nullptr ? _level->GetOuter() : nullptr));
+	CSV_CUSTOM_STAT(FirstRPGStreaming, LoadedCells, numLoadedCells, ECsvCustomStatOp::Set);
+}
+
+void UStreamingStateSubsystem::OnLevelRemoved(ULevel* _level, UWorld* _world)
+{
+	//A null level means the whole world is going away
+	if (_world != GetWorld() || _level == nullptr)
+	{
+		return;
+	}
+
+	numLoadedCells = FMath::Max(0, numLoadedCells - 1);
+	CSV_EVENT(FirstRPGStreaming, TEXT("CellUnloaded %s"), *GetNameSafe(_level->GetOuter()));
+	CSV_CUSTOM_STAT(FirstRPGStreaming, LoadedCells, numLoadedCells, ECsvCustomStatOp::Set);
+}
@@ -0,0 +1,70 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "StreamingStateSubsystem.generated.h"
+
+/**
+ * Keeps the dynamic state of level-placed actors while World Partition has their cell unloaded,
+ * so picked-up collectibles stay gone and dead enemies stay dead when the cell streams back in.
+ * Actors are keyed by name, which World Partition keeps stable across cell loads.
+ */
+
+//What an enemy needs to come back as it was
+USTRUCT()
+struct FEnemyStreamingState
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY()
+	float health = 1.0f;
+
+	UPROPERTY()
+	bool isDead = false;
+};
+
+UCLASS()
+class FIRSTRPG_API UStreamingStateSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	//Only actors that were loaded from level data can be matched up again after a reload
+	static bool IsStreamedActor(const AActor* _actor);
+
+	//Enemy state, stored as the enemy's cell unloads and restored in its BeginPlay
+	void StoreEnemyState(const AActor* _enemy, const FEnemyStreamingState& _state);
+	const FEnemyStreamingState* FindEnemyState(const AActor* _enemy) const;
+
+	//Collectibles call this when picked up and check WasCollected when they begin play
+	UFUNCTION(BlueprintCallable, Category = "Streaming")
+	void MarkCollected(AActor* _pickup);
+
+	UFUNCTION(BlueprintCallable, Category = "Streaming")
+	bool WasCollected(AActor* _pickup) const;
+
+	//Number of streaming levels (World Partition cells) currently in the world
+	UFUNCTION(BlueprintCallable, Category = "Streaming")
+	int GetNumLoadedCells() const { return numLoadedCells; }
+
+private:
+	void OnLevelAdded(ULevel* _level, UWorld* _world);
+	void OnLevelRemoved(ULevel* _level, UWorld* _world);
+
+	UPROPERTY()
+	TMap<FName, FEnemyStreamingState> enemyStates;
+
+	UPROPERTY()
+	TSet<FName> collectedPickups;
+
+	int numLoadedCells = 0;
+
+	FDelegateHandle levelAddedHandle;
+	FDelegateHandle levelRemovedHandle;
+};
@@ -0,0 +1,81 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TelemetryDecodeCommandlet.h"
+#include "FirstRPG.h"
+#include "GameplayTelemetry.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+UTelemetryDecodeCommandlet::UTelemetryDecodeCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UTelemetryDecodeCommandlet::Main(const FString& Params)
+{
+	FString input;
+	if (!FParse::Value(*Params, TEXT("In="), input))
+	{
+		UE_LOG(LogFirstRPG, Error, TEXT("Usage: -run=TelemetryDecode -In=<file or directory> [-Out=<file.csv>]"));
+		return 1;
+	}
+
+	TArray<FString> files;
+	if (IFileManager::Get().DirectoryExists(*input))
+	{
+		IFileManager::Get().FindFiles(files, *(input / TEXT("*.frtl")), true, false);
+		files.Sort();
+		for (FString& file : files)
+		{
+			file = input / file;
+		}
+	}
+	else
+	{
+		files.Add(input);
+	}
+
+	FString output;
+	if (!FParse::Value(*Params, TEXT("Out="), output))
+	{
+		output = FPaths::ChangeExtension(input, TEXT("csv"));
+		if (IFileManager::Get().DirectoryExists(*input))
+		{
+			output = input / TEXT("Telemetry.csv");
+		}
+	}
+
+	TArray<FString> lines;
+	lines.Add(TEXT("File,Seconds,Frame,Event,Subject,Name,Value0,Value1"));
+
+	int32 numFailed = 0;
+	for (const FString& file : files)
+	{
+		const FString fileName = FPaths::GetCleanFilename(file);
+		const bool decoded = FGameplayTelemetry::DecodeFile(file, [&lines, &fileName](const FTelemetryRecord& _record, double _seconds, const FString& _name)
+		{
+			lines.Add(FString::Printf(TEXT("%s,%.6f,%u,%s,%u,%s,%g,%g"), *fileName, _seconds, _record.frame,
+				FGameplayTelemetry::GetEventName(_record.type), _record.subjectId, *_name, _record.value0, _record.value1));
+		});
+
+		if (!decoded)
+		{
+			UE_LOG(LogFirstRPG, Error, TEXT("Could not decode %s"), *file);
+			numFailed++;
+		}
+	}
+
+	if (!FFileHelper::SaveStringArrayToFile(lines, *output))
+	{
+		UE_LOG(LogFirstRPG, Error, TEXT("Could not write %s"), *output);
+		return 1;
+	}
+
+	UE_LOG(LogFirstRPG, Display, TEXT("Decoded %d records from %d files into %s"), lines.Num() - 1, files.Num() - numFailed, *output);
+	return numFailed > 0 ? 1 : 0;
+}
@@ -0,0 +1,26 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "TelemetryDecodeCommandlet.generated.h"
+
+/**
+ * Turns telemetry files into CSV for spreadsheets and scripts:
+ *
+ *     UnrealEditor-Cmd FirstRPG.uproject -run=TelemetryDecode -In=<file or directory> [-Out=<file.csv>]
+ *
+ * A directory decodes every .frtl file in it, oldest first, into one CSV. Without -Out the CSV is
+ * written next to the input.
+ */
+UCLASS()
+class UTelemetryDecodeCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UTelemetryDecodeCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};